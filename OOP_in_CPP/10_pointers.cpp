@@ -1,6 +1,21 @@
 #include <iostream>
 #include <cstring>
 #include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <climits>
+#include <limits>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#if defined(__SSE2__)
+#include <immintrin.h>          // SIMD intrinsics (SSE/AVX)
+#endif
+#include "simd_cstring.h"       // fast_strlen(), fast_strcpy(), fast_strcmp(), fast_strchr()
 using namespace std;
 
 /*
@@ -29,6 +44,10 @@ using namespace std;
 const int MAX = 5;      // Array Size
 int *intPtr;            // Global pointer (initialized to 0 (NULL))
 
+// seconds elapsed since 'start' (used by the benchmark programs at the end of this file)
+double seconds_since(chrono::steady_clock::time_point start)
+{   return chrono::duration<double>(chrono::steady_clock::now() - start).count(); }
+
 
 ///* @brief String class using 'new'
 // with not the same amount of memory for every object,
@@ -36,28 +55,91 @@ int *intPtr;            // Global pointer (initialized to 0 (NULL))
 class String
 {
 private:
-    char *str;
+    enum { SSO_CAP = 23 };          // longest string kept inside the object itself
+    char *str;                      // points to 'local' for short strings, or to memory from 'new'
+    int length;
+    union
+    {
+        char local[SSO_CAP + 1];    // small-string buffer (used when length <= SSO_CAP)
+        int capacity;               // size of the 'new' array (used for long strings)
+    };
+
+    bool is_small() const
+        {   return str == local; }
+    void init(const char* s, int len)
+    {
+        length = len;
+        if(len <= SSO_CAP)
+            {   str = local; }
+        else
+        {
+            str = new char[len + 1];
+            capacity = len + 1;
+        }
+        memcpy(str, s, len + 1);
+    }
+    void steal(String& s)           // take s's contents, leaving s empty
+    {
+        length = s.length;
+        if(s.is_small())
+            {   str = local; memcpy(local, s.local, length + 1); }
+        else
+        {
+            str = s.str;
+            capacity = s.capacity;
+        }
+        s.str = s.local;
+        s.length = 0;
+        s.local[0] = '\0';
+    }
 public:
-    String(char *s)
+    String(const char *s = "")
     { 
-        int length = strlen(s);
-        str = new char[length + 1];
-        strcpy(str, s);
-        // There is no array within the object to hold the string.
-        // >> The string is stored elsewhere; only the pointer to it is a member of 'String'.
+        init(s, fast_strlen(s));
+        // Only long strings are stored elsewhere, and only a pointer to them is a member of 'String'.
+        // >> Short strings (most of them) fit in the object itself, so they need no 'new' at all.
     }
+    String(const String& s)                 // copy constructor: a copy gets its own memory
+        {   init(s.str, s.length); }
+    String(String&& s) noexcept             // move constructor: take the memory of a temporary
+        {   steal(s); }
     ~String()
     {
-        cout << "Deleting String." << endl;
-        delete[] str;
+        if(!is_small())
+            delete[] str;
         // It's reasonable to deallocate the memory when the object is no longer needed.
         // Since this class allocates memory at run time which is not deallocated automatically by itself
         //  when scope terminates, unless it is deallocated deliperately.
-        
-        // ♦ Make sure to pass this class objects by reference as implicitly using the copy constructor in passing by value
-        //      would delete the allocated memory when scope terminates.     
     }
-    void display()
+    String& operator=(const String& s)
+    {
+        if(this == &s)
+            return *this;
+        if(!is_small() && s.length < capacity)      // reuse our memory if it's big enough
+        {
+            length = s.length;
+            memcpy(str, s.str, length + 1);
+            return *this;
+        }
+        if(!is_small())
+            delete[] str;
+        init(s.str, s.length);
+        return *this;
+    }
+    String& operator=(String&& s) noexcept
+    {
+        if(this == &s)
+            return *this;
+        if(!is_small())
+            delete[] str;
+        steal(s);
+        return *this;
+    }
+    int size() const
+        {   return length; }
+    const char* c_str() const
+        {   return str; }
+    void display() const
         { cout << str << endl; }
 };
 /* Note:
@@ -67,6 +149,11 @@ public:
     - The problem is deleting one (deallocating that memory) actually leaves the other pointer dangling.
     = And this can be subtle, because objects can be deleted in nonobvious ways, 
         such as when a function -in which a local object has been created- returns.
+
+    ► That's why String has its own copy constructor and assignment operator (each copy gets its own memory),
+        and move versions that just take the memory of a temporary that is about to be destroyed.
+    ► Small-string optimization: a 'new' for every string, however short, is slow.
+        So strings up to 23 characters are kept in a buffer inside the object, and only longer ones use 'new'.
 */
 
 
@@ -93,9 +180,11 @@ private:
 public:
     void setName()
     {   cout << "Enter name: "; cin >> name; }
+    void setName(const string& n)
+    {   name = n; }
     void printName()
     {   cout << name << endl;}
-    string getName()
+    const string& getName() const       // (by reference: comparing two names doesn't copy them)
     {   return name; }
 };
 
@@ -122,20 +211,80 @@ struct Link         // a list item
 };
 
 
+///* A Slab of Links ........................................................:
+/*
+    Calling 'new' for every single link is expensive when millions of links are added:
+        each call searches the heap for a free space and keeps its own bookkeeping for every link,
+        and the links end up scattered in memory.
+    ► A slab allocator gets memory from 'new' in large blocks (of many links at a time),
+        and hands out the links of the current block one after the other.
+        • Getting a link is then only incrementing a counter.
+        • Links that were added one after the other are next to each other in memory.
+        • Nothing is freed link by link: when the list is destroyed, the whole blocks are deleted.
+*/
+class LinkSlab
+{
+private:
+    static const int MAX_BLOCK = 64 * 1024;     // links per block stop doubling here
+    struct Block
+    {
+        Block* prev;                // the blocks are chained, so all of them can be deleted
+        Link* links;
+    };
+    Block* last;                    // the block links are handed out from
+    int used;                       // links handed out from it
+    int size;                       // links in it
+    LinkSlab(const LinkSlab&);
+    LinkSlab& operator = (const LinkSlab&);
+public:
+    LinkSlab() : last(NULL), used(0), size(0)
+    {   }
+    ~LinkSlab();
+    Link* get();
+};
+
+Link* LinkSlab::get()
+{
+    if(used == size)                // the current block is full: get a new one (twice as big)
+    {
+        size = (size == 0) ? 16 : (size < MAX_BLOCK ? size * 2 : size);
+        Block* b = new Block;
+        b->prev = last;
+        b->links = new Link[size];
+        last = b;
+        used = 0;
+    }
+    return &last->links[used++];
+}
+
+LinkSlab::~LinkSlab()
+{
+    while(last != NULL)
+    {
+        Block* prev = last->prev;
+        delete[] last->links;
+        delete last;
+        last = prev;
+    }
+}
+
+
 class Linklist
 {
 private:
     Link* head;
+    LinkSlab slab;                  // where the links come from (they are all freed with it)
 public:
     Linklist() : head(NULL)
     {   }
     void add_item(int);
     void display();
+    long long sum();
 };
 
 void Linklist::add_item(int d)
 {
-    Link* newlink = new Link;       // allocates memory for a new link
+    Link* newlink = slab.get();     // takes the memory for a new link from the slab
     newlink->data = d;              // set the data variable to the value passed as an argument
     newlink->next = head;           // A new link is inserted at the beginning of the list
     head = newlink;                 // head points to the newest link
@@ -171,6 +320,239 @@ void Linklist::display()
     //     {   cout << current->data << endl; }
 }
 
+long long Linklist::sum()
+{
+    long long total = 0;
+    for(Link* current = head; current != NULL; current = current->next)
+        total += current->data;
+    return total;
+}
+
+
+///* Unrolled Linked list ......................................................:
+/*
+    Following a 'next' pointer to every single int means that the CPU can't know where the next item is
+        until it has loaded the current one. Once the list doesn't fit in the cache, every step waits for main memory.
+    ► An unrolled list stores many items in every link (an array of NODE_INTS ints),
+        • so there is only one pointer to follow for every NODE_INTS items,
+        • and the items within a link are read one after the other, just like an array.
+    It keeps the interface of Linklist: add_item() adds at the front, and display() shows the newest item first.
+*/
+class UnrolledList
+{
+private:
+    static const int NODE_INTS = 60;    // so a node takes 256 bytes (4 cache lines)
+    struct Node
+    {
+        Node* next;
+        int first;                      // data[first] ... data[NODE_INTS - 1] are in use
+        int data[NODE_INTS];            // filled from the back, so the newest item is data[first]
+    };
+    Node* head;
+    UnrolledList(const UnrolledList&);
+    UnrolledList& operator = (const UnrolledList&);
+public:
+    UnrolledList() : head(NULL)
+    {   }
+    ~UnrolledList();
+    void add_item(int);
+    void display();
+    long long sum();
+};
+
+UnrolledList::~UnrolledList()
+{
+    while(head != NULL)
+    {
+        Node* next = head->next;
+        delete head;
+        head = next;
+    }
+}
+
+void UnrolledList::add_item(int d)
+{
+    if(head == NULL || head->first == 0)    // the head node is full: a new node goes in front of it
+    {
+        Node* newnode = new Node;
+        newnode->next = head;
+        newnode->first = NODE_INTS;
+        head = newnode;
+    }
+    head->data[--head->first] = d;
+}
+
+void UnrolledList::display()
+{
+    for(Node* current = head; current != NULL; current = current->next)
+        for(int i = current->first; i < NODE_INTS; i++)
+            cout << current->data[i] << endl;
+}
+
+long long UnrolledList::sum()
+{
+    long long total = 0;
+    for(Node* current = head; current != NULL; current = current->next)
+    {
+        const int* p = current->data;
+        for(int i = current->first; i < NODE_INTS; i++)     // a plain array loop (the compiler can vectorize it)
+            total += p[i];
+    }
+    return total;
+}
+
+
+///* A Linked list Shared by Many Threads ..............................................:
+/*
+    Linklist::add_item() changes 'head' in two steps (read it, then write the new link),
+        so two threads adding at the same time can both read the same old head, and one of the links is lost.
+
+    ► Lock-free push at the front:
+        The new link is prepared first (newlink->next = the head we saw), 
+        then 'head' is changed with an atomic compare-and-swap (CAS): 
+            "make head = newlink, but only if head is still newlink->next".
+        If another thread got in first, the CAS fails, gives us the new head, and we simply try again.
+
+    ► Consistent snapshots:
+        A link is never changed after it is on the list, so a reader that loads 'head' once
+            sees a complete, unchanging list from that link to the end (even while others keep pushing in front of it.)
+
+    ► Freeing memory safely (epochs):
+        clear() detaches the whole chain of links from 'head', but a reader may still be walking that chain.
+        • Every reader announces the current 'epoch' (a global counter) while it reads, in one slot of a small table.
+        • A detached chain is 'retired' with the epoch at which it was detached (not deleted.)
+        • The epoch moves on only when every active reader has announced the current epoch,
+            so once it has moved on twice, no reader can still hold a link of the chain, and it is deleted.
+*/
+class EpochManager
+{
+private:
+    static const int SLOTS = 64;                // readers at the same time
+    struct alignas(64) Slot                     // (one cache line each, so readers don't slow each other down)
+    {   atomic<unsigned> state; };              // 0: free, otherwise (epoch << 1) | 1
+    Slot slots[SLOTS];
+    atomic<unsigned> epoch;
+    mutex retireLock;                           // retiring and advancing are rare (clear() only)
+    vector<Link*> limbo[3];                     // chains retired in epoch e wait in limbo[e % 3]
+    static void delete_chain(Link* p);
+    bool try_advance();
+public:
+    EpochManager() : epoch(0)
+    {   for(int i = 0; i < SLOTS; i++) slots[i].state.store(0); }
+    ~EpochManager();
+    int enter();                                // before reading: returns the slot to pass to leave()
+    void leave(int slot)
+    {   slots[slot].state.store(0, memory_order_release); }
+    void retire(Link* chain);                   // delete the chain when no reader can see it any more
+};
+
+int EpochManager::enter()
+{
+    int i = int(hash<thread::id>()(this_thread::get_id()) % SLOTS);
+    for( ; ; i = (i + 1) % SLOTS)               // claim a free slot
+    {
+        unsigned expected = 0;
+        unsigned mine = (epoch.load() << 1) | 1;
+        if(slots[i].state.load(memory_order_relaxed) == 0 && slots[i].state.compare_exchange_strong(expected, mine))
+            return i;                           // (seq_cst: announced before any link is read)
+    }
+}
+
+void EpochManager::retire(Link* chain)
+{
+    lock_guard<mutex> guard(retireLock);
+    limbo[epoch.load() % 3].push_back(chain);
+    try_advance();
+    try_advance();
+}
+
+bool EpochManager::try_advance()
+{
+    unsigned e = epoch.load();
+    for(int i = 0; i < SLOTS; i++)
+    {
+        unsigned st = slots[i].state.load();
+        if(st != 0 && (st >> 1) != e)           // a reader is still in an older epoch
+            return false;
+    }
+    epoch.store(e + 1);
+    vector<Link*>& old = limbo[(e + 2) % 3];    // retired in epoch e - 1: nobody can see them now
+    for(size_t i = 0; i < old.size(); i++)
+        delete_chain(old[i]);
+    old.clear();
+    return true;
+}
+
+void EpochManager::delete_chain(Link* p)
+{
+    while(p != NULL)
+    {
+        Link* next = p->next;
+        delete p;
+        p = next;
+    }
+}
+
+EpochManager::~EpochManager()
+{
+    for(int e = 0; e < 3; e++)
+        for(size_t i = 0; i < limbo[e].size(); i++)
+            delete_chain(limbo[e][i]);
+}
+
+
+class ConcurrentLinklist
+{
+private:
+    atomic<Link*> head;
+    EpochManager epochs;
+    ConcurrentLinklist(const ConcurrentLinklist&);
+    ConcurrentLinklist& operator = (const ConcurrentLinklist&);
+public:
+    ConcurrentLinklist() : head(NULL)
+    {   }
+    ~ConcurrentLinklist()
+    {   epochs.retire(head.exchange(NULL)); }  // (the EpochManager deletes it)
+    void add_item(int d);                       // any number of threads may add at the same time
+    long long sum(long* count = NULL);          // sums a snapshot of the list
+    long long clear(long* count = NULL);        // removes everything; returns the sum of what was removed
+};
+
+void ConcurrentLinklist::add_item(int d)
+{
+    Link* newlink = new Link;
+    newlink->data = d;
+    newlink->next = head.load(memory_order_relaxed);
+    // on failure, compare_exchange_weak() puts the current head into newlink->next, ready for the next try
+    while(!head.compare_exchange_weak(newlink->next, newlink, memory_order_release, memory_order_relaxed))
+        ;
+}
+
+long long ConcurrentLinklist::sum(long* count)
+{
+    int slot = epochs.enter();
+    long long total = 0;
+    long n = 0;
+    for(Link* current = head.load(memory_order_acquire); current != NULL; current = current->next)
+    {   total += current->data; n++; }
+    epochs.leave(slot);
+    if(count) *count = n;
+    return total;
+}
+
+long long ConcurrentLinklist::clear(long* count)
+{
+    Link* chain = head.exchange(NULL, memory_order_acq_rel);
+    long long total = 0;
+    long n = 0;
+    for(Link* current = chain; current != NULL; current = current->next)
+    {   total += current->data; n++; }
+    if(chain != NULL)
+        epochs.retire(chain);
+    if(count) *count = n;
+    return total;
+}
+
 
 ///* Parsing Arithmetic Operations .....................................................:
 // evaluates arithmetic expressions composed of 1-digit numbers.
@@ -178,18 +560,46 @@ void Linklist::display()
 class Stack
 {
 private:
-    static const int SIZE = 40;
+    static const int SIZE = 40;         // inline capacity: enough for any typical expression
     char st[SIZE];
+    char* pSt;                          // points to 'st', or to a heap array once the stack outgrows it
+    int capacity;
     int top;
+    void grow();
+    Stack(const Stack&);                // not copyable: it may own heap memory
+    Stack& operator = (const Stack&);
 public:
-    Stack() : top(-1) { };
+    Stack() : pSt(st), capacity(SIZE), top(-1) { };
+    ~Stack()
+    {   if(pSt != st) delete[] pSt; }
     void push(char var)
-    {   st[++top] = var; }
+    {
+        if(top + 1 == capacity)
+            grow();
+        pSt[++top] = var;
+    }
     char pop()
-    {   return st[top--]; }
+    {   return pSt[top--]; }
+    char peek() const
+    {   return pSt[top]; }
     int get_top()
     {   return top; }
 };
+/* A growable stack:
+    A fixed 'char st[SIZE]' overflows (silently writing past the array) for deeper expressions.
+    Allocating the whole stack with 'new' would fix that, but then every Stack would go to the heap.
+    ► So, the first SIZE items live inside the object itself, 
+        and only a stack deeper than that moves its items to a heap array (doubling its capacity each time.)
+*/
+void Stack::grow()
+{
+    char* p = new char[capacity * 2];
+    memcpy(p, pSt, capacity);
+    if(pSt != st)
+        delete[] pSt;
+    pSt = p;
+    capacity *= 2;
+}
 
 const int LEN = 80;
 
@@ -258,414 +668,2903 @@ void Expr::solve_last_op()
     }
 } 
 
-    
-////////////////////////////////////////////////////////////////////////////////////////
-int main()
+
+///* A Streaming Tokenizer ..............................................................:
+/*
+    The tokenizer reads the input buffer from left to right and hands back one token at a time:
+        • numbers of any number of digits (45, 1024), variables (a..z), operators and parentheses,
+        • spaces are skipped,
+        • a token is returned by value, so no memory is allocated for any token,
+        • an error is returned as a TOK_ERROR token instead of exiting the program.
+*/
+enum TokenType { TOK_NUMBER, TOK_VAR, TOK_OP, TOK_LPAREN, TOK_RPAREN, TOK_END, TOK_ERROR };
+
+struct Token
 {
-    int v1 = 26;
-    cout << &v1 << endl;        // & var : address of var
+    TokenType type;
+    int value;          // the number (TOK_NUMBER), the variable number (TOK_VAR), or the operator character (TOK_OP)
+    int pos;            // where the token starts in the input
+};
 
-    int* ptr = &v1;             // int * : a pointer to int
-    cout << ptr << endl;
-    cout << *ptr << endl;       // * ptr : dereference ptr 
+class Tokenizer
+{
+private:
+    const char* begin;
+    const char* p;      // next character to read
+    const char* end;
+    const char* errMsg;     // describes the last TOK_ERROR
+public:
+    Tokenizer(const char* first, const char* last) : begin(first), p(first), end(last), errMsg(NULL)
+    {   }
+    Token next();
+    const char* error() const
+    {   return errMsg; }
+};
 
-    char *ptr1, *ptr2, *ptr3;   // defining multible pointers on the same line
+Token Tokenizer::next()
+{
+    while(p != end && *p == ' ')
+        p++;
 
-    int v2 = *ptr;
-    cout << v2 << endl;
+    Token tok = { TOK_END, 0, int(p - begin) };
+    if(p == end || *p == '\0')
+        return tok;
 
-    /* Note:
-        The pointer must be given some value, or it will point to an addresss we don't want it to point to.
-        >> Rogue pointer values can result in system crashes and are difficult to debug.
-        So, Make sure you give every pointer variable a valid address value before using it (ex.: NULL).
-    */
+    char ch = *p;
+    if(ch >= '0' && ch <= '9')
+    {
+        tok.type = TOK_NUMBER;
+        for( ; p != end && *p >= '0' && *p <= '9'; p++)
+        {
+            if(tok.value > INT_MAX / 10 || (tok.value == INT_MAX / 10 && *p - '0' > INT_MAX % 10))
+            {   tok.type = TOK_ERROR; errMsg = "number too large"; return tok; }
+            tok.value = tok.value * 10 + (*p - '0');
+        }
+        return tok;
+    }
 
-    ///* To assign one kind of pointer type to another ................................:
-    float flovar = 98.6;
-    // int* ptrint = &flovar;   //ERROR: can't assign float* to int*
-    int *ptrint = reinterpret_cast<int*>(&flovar); 
-    // Static casts won't work with pointers. 
-    // Old-style C casts can be used, but are always a bad idea in C++.
+    p++;
+    if(ch >= 'a' && ch <= 'z')
+    {   tok.type = TOK_VAR; tok.value = ch - 'a'; }
+    else if(ch == '+' || ch == '-' || ch == '*' || ch == '/')
+    {   tok.type = TOK_OP; tok.value = ch; }
+    else if(ch == '(')
+        tok.type = TOK_LPAREN;
+    else if(ch == ')')
+        tok.type = TOK_RPAREN;
+    else
+    {   tok.type = TOK_ERROR; errMsg = "unknown input character"; }
+    return tok;
+}
 
 
-    ///* void pointers ................................................................:
-    void *vptr;     // vptr can point to any data type.
-                    // • Can be used to pass pointers to functions that operate
-                    //   independently of the data type pointed to.
-    int ivar;
-    float fvar;
-    vptr = &ivar;   // Ok
-    vptr = &fvar;   // Ok
-    
+///* Compiling Expressions to Bytecode .................................................:
+/*
+    Expr::evaluate() walks the raw characters and pushes/pops its Stack on every call.
+    If the same formula is evaluated many times, all that parsing work is repeated every time.
+
+    ► Instead, we can 'compile' the expression once into a small program of instructions (bytecode):
+        2+3*4  →  CONST 2, CONST 3, CONST 4, MUL, ADD
+    then 'run' this program as many times as we want with a tight interpreter loop.
+        • The precedence of * and / over + and - is resolved once, at compile time (postfix order).
+        • Running the program is only a loop over an array with a switch statement.
+*/
+enum OpCode { OP_CONST, OP_VAR, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_NEG, OP_SAVE, OP_LOAD };
 
-    ///* A capsule summary ...........................................................:
-    int v;      // defines variable v of type int
-    float f;    // defines variable f of type float
-    int* p;     // defines p as a pointer to int
-    p = &v;     // assigns address of variable v to pointer p
-    v = 3;      // assigns 3 to v
-    *p = 3;     // also assigns 3 to v
-    void* vp;   // defines vp as a pointer to void 
-    vp = &v;    // assigns address of variable v to pointer vp
-    vp = &f;    // assigns address of variable f to pointer vp
-    p = reinterpret_cast<int*>(&f);     // assigns address of float variable f to the pointer to int p
+struct Instr        // one bytecode instruction
+{
+    OpCode op;
+    int arg;        // the constant value (OP_CONST), the variable number (OP_VAR), or the slot number (OP_SAVE, OP_LOAD)
+};
 
-    
-    ///* Pointers and Arrays .........................................................:
-    int i;
-    int intArr[5] = {56, 62, 96, 45, 12};                   // Note: the address of an array is always a constant.
-    for (i = 0; i < 5; i++)
-    {   cout << endl << *(intArr + i); } cout << endl;      // the name of an array is its address
-    // The C++ compiler is smart enough (using the pointer type) to take the size of the data into account when
-    //   it performs arithmetic on data addresses (here it increments by the size of int.)
-    /* Note:
-        Array name is a pointer constant (a non-modifiable lvalue) NOT a pointer variable,
-        Which means that it is the address where the system has chosen to place your array.
-        intArr++;  is like  0x36466631++;
-        But intArr[i] is an lvalue because, it is: *(intArr + i)
-    */
 
-    int *iArrptr = intArr;
-    for (i = 0; i < 5; i++)
-    {   cout << endl << *(iArrptr++); } cout << endl;
-    // because iArrptr is a variable and not a constant, it can be incremented. 
+class ExprProgram
+{
+private:
+    static const int INLINE_DEPTH = 32; // run() keeps a value stack this deep on the function's own stack
+    static const int BLOCK = 256;       // rows evaluated together by run_batch()
+    vector<Instr> code;
+    int depth;                          // the deepest the value stack gets while running
+    int nVars;                          // variables used: 'a' is vars[0], 'b' is vars[1], ...
+    int nSlots;                         // slots holding the values of common subexpressions
+    const char* errMsg;                 // why the last compile() failed (NULL if it did not)
+    int errPos;                         // and where, in the input
+    void emit(OpCode op, int arg = 0);  // (folds constants)
+    void reuse_common_subexpressions();
+    int stack_depth() const;
+public:
+    ExprProgram() : depth(0), nVars(0), nSlots(0), errMsg(NULL), errPos(0)
+    {   }
+    bool compile(const char* str);      // returns false for a malformed expression (see error())
+    bool compile(const char* first, const char* last);
+    const char* error() const
+    {   return errMsg; }
+    int error_pos() const
+    {   return errPos; }
+    // An int division by 0 (or INT_MIN / -1) stops the program: run() then returns 0 and sets *err (if err is given).
+    int run(const char** err = NULL) const              // an expression of constants only
+    {   return run<int>(NULL, err); }
+    template <class T>
+    T run(const T* vars, const char** err = NULL) const;    // one row: vars[0] is the value of 'a', ...
+    template <class T>
+    bool run_batch(const T* const* cols, int nRows, T* out, const char** err = NULL) const;
+    int size() const
+    {   return code.size(); }
+    int vars_used() const
+    {   return nVars; }
+};
 
-    
-    ///* Passing by pointer ..........................................................:
-    void centimize(double*);
-    
-    double dist = 10.0;     // in inches
-    cout << "\ndist = " << dist << " inches" << endl;
-    
-    centimize(&dist);
-    cout << "dist = " << dist << " centimeters" << endl;
-    
+// operators with higher precedence are emitted first ('u' is the unary minus)
+static int precedence(char op)
+{
+    switch(op)
+    {
+    case 'u': return 3;
+    case '*': case '/': return 2;
+    case '+': case '-': return 1;
+    default:  return 0;             // '('
+    }
+}
 
-    ///* Passing Arrays ..............................................................:
-    void centimizeArr(double*);
-    
-    double dblArr[MAX] = {10.0, 43.1, 95.9, 59.7, 87.3};
-    centimizeArr(dblArr);
-    
-    for ( i = 0; i < MAX; i++)
-    {   cout << "\ndblArr[" << i << "] = " << dblArr[i] << " cm"; } cout << endl;
-    
+static OpCode opcode_of(char op)
+{
+    switch(op)
+    {
+    case '+': return OP_ADD;
+    case '-': return OP_SUB;
+    case '*': return OP_MUL;
+    case 'u': return OP_NEG;
+    default:  return OP_DIV;
+    }
+}
 
-    ///* Array Bubble Sort ............................................................:
-    void BubbleSort(int *, int);
-    int intArr2[MAX] = {61, 46, 49, 32, 64};
-    BubbleSort(intArr2, MAX);
-    
-    for (i = 0; i < MAX; i++)
-    {   cout << endl << intArr2[i]; } cout << endl;
-    
+bool ExprProgram::compile(const char* str)
+{   return compile(str, str + strlen(str)); }
 
-    ///* Pointers to string ..........................................................:
-    char str1[] = "Defined as an array";            // A string constant can be defined as an array or as a pointer. 
-    char *str2 = (char*)"Defined as a pointer";     // The pointer approach may be more flexible, 
-                                                    //  → but there is a danger that the pointer value will be corrupted.
-    cout << str1 << endl;
-    cout << str2 << endl;
-    
-    //  str1++;         // can't do this; str1 is a constant
-        str2++;         // this is ok, str2 is a pointer
+bool ExprProgram::compile(const char* first, const char* last)
+{
+    Tokenizer tokens(first, last);
+    Stack ops;                          // pending operators and '(' (not yet emitted)
+    bool wantNumber = true;             // operands and binary operators must alternate
 
-    void dispStr(char*);
-    dispStr(str1);
-    dispStr(str2);
+    code.clear();
+    depth = 0;
+    nVars = 0;
+    nSlots = 0;
+    errMsg = NULL;
 
-    void cpyStr(char*, const char*);
-    char *str3 = (char*)"Self-conquest is the greatest victory.";
-    char str4[50];
-    cpyStr(str4, str3);
-    cout << str4 << endl;
+    for(Token tok = tokens.next(); tok.type != TOK_END; tok = tokens.next())
+    {
+        errPos = tok.pos;
+        switch(tok.type)
+        {
+        case TOK_NUMBER:
+        case TOK_VAR:
+            if(!wantNumber)
+            {   errMsg = "operator expected"; return false; }
+            if(tok.type == TOK_NUMBER)
+                emit(OP_CONST, tok.value);
+            else
+            {
+                emit(OP_VAR, tok.value);
+                if(tok.value >= nVars) nVars = tok.value + 1;
+            }
+            wantNumber = false;
+            break;
+
+        case TOK_OP:
+            if(wantNumber)              // an operator where an operand should be: a sign
+            {
+                if(tok.value == '-')
+                    ops.push('u');
+                else if(tok.value != '+')
+                {   errMsg = "operand expected"; return false; }
+                break;
+            }
+            // pop every pending operator that binds at least as tightly (left associativity)
+            while(ops.get_top() >= 0 && precedence(ops.peek()) >= precedence(tok.value))
+            {   emit(opcode_of(ops.pop())); }
+            ops.push(tok.value);
+            wantNumber = true;
+            break;
+
+        case TOK_LPAREN:
+            if(!wantNumber)
+            {   errMsg = "operator expected"; return false; }
+            ops.push('(');
+            break;
+
+        case TOK_RPAREN:
+            if(wantNumber)
+            {   errMsg = "operand expected"; return false; }
+            while(ops.get_top() >= 0 && ops.peek() != '(')
+            {   emit(opcode_of(ops.pop())); }
+            if(ops.get_top() < 0)
+            {   errMsg = "unmatched ')'"; return false; }
+            ops.pop();                  // discard the '('
+            break;
+
+        default:                        // TOK_ERROR
+            errMsg = tokens.error();
+            return false;
+        }
+    }
 
-    
-    ///* const modifiers and pointers ................................................:
-    const int ciVar = 4;
-    int iVar = 5;
-    
-    /// pointer to const int:
-    const int * pcInt;                  // pointer to const int
-    int const * pcInt2;                 // same thing ...
-    pcInt = &ciVar;                     // points to const int
-    pcInt = &iVar;                      // points to int
-    ivar = 6;                           // ivar value stll can be changed (it's stll int not const int)
-    // 'const int' must be pointed to by (pointers to const int),
-    //  while 'int' can be pointed to by either a (ptr to int) or a (ptr to const int [here it does not mean that the var int cannot be changed].)
-    
-    /// const pointer to int:
-    int * const cpInt = &iVar;          // (const pointer) to int (you cannot change the value of the pointer.)
-    // int * const cpInt2 = &ciVar;     // Error: cannot point to const int
-    // cpInt = &v1;                     // Error: you cannot change const ptr value 
+    errPos = last - first;
+    if(wantNumber)                      // empty expression, or ends with an operator
+    {   errMsg = "operand expected"; return false; }
 
-    /// const pointer to const int:
-    const int * const cpcInt = &ciVar;
-    
+    while(ops.get_top() >= 0)
+    {
+        char op = ops.pop();
+        if(op == '(')
+        {   errMsg = "missing ')'"; return false; }
+        emit(opcode_of(op));
+    }
 
-    ///* Arrays of strings ..........................................................:
-    /* Note:
-        There is a disadvantage to using an array of strings, 
-        in that the subarrays that hold the strings must all be the same length. */
-    // But we can use pointers to solve this problem:
-    
-    const int DAYS = 7;
-    char* pDays[DAYS] = {"Saturday", "Sunday", "Monday", "Tuesday",
-                        "Wedensday", "Thursday", "Friday"};
-    for (i = 0; i < DAYS; i++)
-    {   cout << endl << pDays[i]; } cout << endl;
-    
-    // • The char pointer holds the address of the head character in the string. 
-    //      It is these addresses that are stored in the array. 
-    //      (while actual strings' values are not part of the array.)
-   
-    // • When strings are not part of an array, C++ places them 'contiguously' in memory,
-    //      So there is no wasted space.
-    
-    
-    ///* Memory Management: 'new' and 'delete' ......................................:
-    
-    // The 'new' operator: obtains memory from the operating system
-    //   and returns a pointer to its starting point (with the appropraite data type.) 
-    char str5[] = "Idle hands are the devil's workshop.";
-    int len = strlen(str5);
-    
-    char *pch;
-    pch = new char[len + 1];        // sets aside memory: string + '\0' (dynamically allocated memory)
+    reuse_common_subexpressions();
+    depth = stack_depth();
+    return true;
+}
 
-    strcpy(pch, str5);
-    cout << "\npch = " << pch << endl;
-    
-    /* There is no C++ equivalent to 'realloc' where you can change the size of memory that has been alloctaed.
-        - You'll need to fall back on the ploy of creating a larger (or smaller) space with new, 
-            and copying your data from the old area to the new one.  
-    */
-    
-    delete[] pch;                   // release pointer's memory
+// the error of an integer division a / b, or NULL if it can be done (a double division never fails: 1.0/0 is inf)
+template <class T>
+inline const char* division_error(T a, T b)
+{
+    if(!numeric_limits<T>::is_integer)
+        return NULL;
+    if(b == 0)
+        return "division by zero";
+    if(b == T(-1) && a == numeric_limits<T>::min())
+        return "division overflow";     // INT_MIN / -1 is INT_MAX + 1
+    return NULL;
+}
 
-    /* Using new and delete in functions
-        - If the function uses a local variable as a pointer to this memory, 
-            the pointer will be destroyed when the function terminates.
-        BUT: the memory will be left as an orphan, taking up space that is inaccessible to the rest of the program. 
-            So, Thus it is always good practice, and often essential, to delete memory when you're through with it.
-    */
-    // Note: Deleting the memory doesn't delete the pointer that points to it.
-    //       and doesn't change the address value in the pointer. 
-    //       However, this address is no longer valid (doesn't point to allocated memory.)
+template <class T>
+T ExprProgram::run(const T* vars, const char** err) const
+{
+    T inlineSt[INLINE_DEPTH];
+    vector<T> heapSt;                   // used only by programs deeper than INLINE_DEPTH
+    T* st = inlineSt;
+    if(depth + nSlots > INLINE_DEPTH)
+    {   heapSt.resize(depth + nSlots); st = heapSt.data(); }
+    T* slots = st + depth;
+
+    int top = -1;
+    const Instr* pc = code.data();
+    const Instr* end = pc + code.size();
+
+    for( ; pc != end; pc++)
+    {
+        switch(pc->op)
+        {
+        case OP_CONST: st[++top] = pc->arg; break;
+        case OP_VAR: st[++top] = vars[pc->arg]; break;
+        case OP_ADD: top--; st[top] += st[top + 1]; break;
+        case OP_SUB: top--; st[top] -= st[top + 1]; break;
+        case OP_MUL: top--; st[top] *= st[top + 1]; break;
+        case OP_DIV:
+            top--;
+            if(const char* e = division_error(st[top], st[top + 1]))
+            {   if(err) *err = e; return 0; }   // (the CPU would stop the whole program with SIGFPE)
+            st[top] /= st[top + 1];
+            break;
+        case OP_NEG: st[top] = -st[top]; break;
+        case OP_SAVE: slots[pc->arg] = st[top]; break;
+        case OP_LOAD: st[++top] = slots[pc->arg]; break;
+        }
+    }
+    if(err) *err = NULL;
+    return st[top];
+}
+/* Note:
+    The values of an ExprProgram are 'int', while Expr keeps them on its 'char' Stack,
+        so Expr overflows as soon as an intermediate result exceeds 127.
+    Expr also resolves the operators left on its stack at the end from right to left, 
+        so 2-3*4-1 gives -9 with Expr::evaluate() but the correct -11 with ExprProgram::run().
+*/
 
-    char* chPtrsArray[MAX];         // Array of pointers to chars
-    for (i = 0; i < MAX; i++)       // allocated memory for char for every pointer
-    {   chPtrsArray[i] = new char; }
-    
-    // To delete the allocated memory for every pointer:
-    for (i = 0; i < MAX; i++)
-    {   delete chPtrsArray[i]; }
-    // Note:
-    // delete[] chPtrsArray;        // will delete the array of pointers, NOT the allocated memory that every pointers point to.
-    
+
+///* Optimizing the Program ............................................................:
+/*
+    • Constant folding:
+        An operator whose operands are both constants can be computed once, at compile time:
+            (2+3)*a  →  CONST 5, VAR a, MUL     instead of     CONST 2, CONST 3, ADD, VAR a, MUL
+        emit() does this as every operator is emitted, so a fully-constant expression becomes a single CONST.
+        ► a division is folded only when it is exact, so an 'int' and a 'double' run still agree (7/2 is 3 for one and 3.5 for the other.)
+        ► a+2+3 is not folded into a+5: that would change the order of the operations (a+2 is computed first.)
+
+    • Common subexpressions:
+        In postfix code every subexpression is a contiguous run of instructions that ends with its operator.
+        If the same run appears twice, the second one can reuse the value computed by the first:
+            (a*b+c)/(a*b+c)  →  VAR a, VAR b, MUL, VAR c, ADD, SAVE 0, LOAD 0, DIV
+        SAVE copies the top value into a slot (without popping it) and LOAD pushes it back later.
+*/
+void ExprProgram::emit(OpCode op, int arg)
+{
+    int n = code.size();
+    if(op == OP_NEG && n >= 1 && code[n - 1].op == OP_CONST && code[n - 1].arg != INT_MIN)
+    {   code[n - 1].arg = -code[n - 1].arg; return; }
+
+    if(op >= OP_ADD && op <= OP_DIV && n >= 2 && code[n - 1].op == OP_CONST && code[n - 2].op == OP_CONST)
+    {
+        long long a = code[n - 2].arg, b = code[n - 1].arg, r;
+        bool fold = true;
+        switch(op)
+        {
+        case OP_ADD: r = a + b; break;
+        case OP_SUB: r = a - b; break;
+        case OP_MUL: r = a * b; break;
+        default:     fold = (b != 0 && a % b == 0); r = fold ? a / b : 0; break;
+        }
+        if(fold && r >= INT_MIN && r <= INT_MAX)   // (an overflow is left to happen at run time, as it would without folding)
+        {
+            code.pop_back();
+            code[n - 2].arg = int(r);
+            return;
+        }
+    }
+
+    Instr in = { op, arg };
+    code.push_back(in);
+}
+
+// replaces every repeated subexpression by a LOAD of the value saved by its first occurrence
+void ExprProgram::reuse_common_subexpressions()
+{
+    int n = code.size();
+    nSlots = 0;
+    if(n < 7)                           // the smallest program with a repeated operator: a b * a b * +
+        return;
+
+    vector<int> start(n);               // instruction i ends the subexpression [start[i], i]
+    vector<unsigned> hash(n);
+    vector<int> firstOf(n, -1);         // for a repeated subexpression: where its first occurrence ends
+    vector<int> values;                 // the subexpressions on the stack (by their last instruction)
+    unordered_map<unsigned, vector<int> > seen;
+
+    for(int i = 0; i < n; i++)
+    {
+        unsigned h = unsigned(code[i].op) * 0x9E3779B1u ^ unsigned(code[i].arg);
+        start[i] = i;
+        if(code[i].op >= OP_ADD && code[i].op <= OP_DIV)
+        {
+            int right = values.back(); values.pop_back();
+            int left = values.back(); values.pop_back();
+            start[i] = start[left];
+            h ^= (hash[left] * 31 + hash[right]) * 0x85EBCA6Bu;
+        }
+        else if(code[i].op == OP_NEG)
+        {
+            int operand = values.back(); values.pop_back();
+            start[i] = start[operand];
+            h ^= hash[operand] * 0xC2B2AE35u;
+        }
+        hash[i] = h;
+        values.push_back(i);
+
+        if(i == start[i])               // a single CONST or VAR is not worth a slot
+            continue;
+        vector<int>& same = seen[h];
+        for(size_t k = 0; k < same.size() && firstOf[i] < 0; k++)
+        {
+            int j = same[k];
+            if(j - start[j] == i - start[i])
+            {
+                int m = 0;
+                while(m <= i - start[i] && code[start[j] + m].op == code[start[i] + m].op
+                                        && code[start[j] + m].arg == code[start[i] + m].arg)
+                    m++;
+                if(m > i - start[i])
+                    firstOf[i] = j;
+            }
+        }
+        if(firstOf[i] < 0)
+            same.push_back(i);
+    }
+
+    // only the outermost repeats are replaced (walking backwards, they are met before the ones inside them)
+    vector<int> replaceEnd(n, -1);      // replaceEnd[s] = e: the repeat [s, e] becomes one LOAD
+    vector<int> slotOf(n, -1);          // slotOf[j]: the slot that the first occurrence ending at j is saved into
+    int coveredFrom = n;
+    for(int i = n - 1; i >= 0; i--)
+    {
+        if(i >= coveredFrom)
+            continue;
+        coveredFrom = n;
+        if(firstOf[i] >= 0)
+        {
+            replaceEnd[start[i]] = i;
+            coveredFrom = start[i];
+            if(slotOf[firstOf[i]] < 0)
+                slotOf[firstOf[i]] = nSlots++;
+        }
+    }
+    if(nSlots == 0)
+        return;
+
+    vector<Instr> out;
+    for(int i = 0; i < n; i++)
+    {
+        if(replaceEnd[i] >= 0)
+        {
+            Instr load = { OP_LOAD, slotOf[firstOf[replaceEnd[i]]] };
+            out.push_back(load);
+            i = replaceEnd[i];
+            continue;
+        }
+        out.push_back(code[i]);
+        if(slotOf[i] >= 0)
+        {
+            Instr save = { OP_SAVE, slotOf[i] };
+            out.push_back(save);
+        }
+    }
+    code.swap(out);
+}
+
+// the deepest the value stack gets while running the program
+int ExprProgram::stack_depth() const
+{
+    int cur = 0, deepest = 0;
+    for(size_t i = 0; i < code.size(); i++)
+    {
+        switch(code[i].op)
+        {
+        case OP_CONST: case OP_VAR: case OP_LOAD:
+            if(++cur > deepest) deepest = cur;
+            break;
+        case OP_NEG: case OP_SAVE:
+            break;
+        default:
+            cur--;
+        }
+    }
+    return deepest;
+}
+
+
+///* Evaluating a Program over Columns of Variables ....................................:
+/*
+    Calling run() once per row pays the interpreter overhead (fetch, switch) for every single row.
+    run_batch() turns the loop inside out:
+        • each instruction is applied to a whole block of BLOCK rows before moving to the next instruction,
+            so every stack slot holds a block of values instead of one value,
+        • the work per instruction is then a plain loop over arrays (a 'kernel'),
+            which the CPU can run with SIMD instructions: 4 doubles or 8 ints per AVX register.
+*/
+// generic kernels: a[i] = a[i] op b[i]
+template <class T> void add_block(T* a, const T* b, int n) { for(int i = 0; i < n; i++) a[i] += b[i]; }
+template <class T> void sub_block(T* a, const T* b, int n) { for(int i = 0; i < n; i++) a[i] -= b[i]; }
+template <class T> void mul_block(T* a, const T* b, int n) { for(int i = 0; i < n; i++) a[i] *= b[i]; }
+template <class T> void div_block(T* a, const T* b, int n) { for(int i = 0; i < n; i++) a[i] /= b[i]; }
+// (there is no SIMD integer division, so div_block<int> always stays a scalar loop)
+
+#if defined(__AVX__)
+// 4 doubles per step
+#define DOUBLE_KERNEL(NAME, INTRIN, OP)                                     \
+template <> void NAME<double>(double* a, const double* b, int n)            \
+{                                                                           \
+    int i = 0;                                                              \
+    for( ; i + 4 <= n; i += 4)                                              \
+        _mm256_storeu_pd(a + i, INTRIN(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i))); \
+    for( ; i < n; i++)                                                      \
+        a[i] OP b[i];                                                       \
+}
+DOUBLE_KERNEL(add_block, _mm256_add_pd, +=)
+DOUBLE_KERNEL(sub_block, _mm256_sub_pd, -=)
+DOUBLE_KERNEL(mul_block, _mm256_mul_pd, *=)
+DOUBLE_KERNEL(div_block, _mm256_div_pd, /=)
+#undef DOUBLE_KERNEL
+#elif defined(__SSE2__)
+// 2 doubles per step
+#define DOUBLE_KERNEL(NAME, INTRIN, OP)                                     \
+template <> void NAME<double>(double* a, const double* b, int n)            \
+{                                                                           \
+    int i = 0;                                                              \
+    for( ; i + 2 <= n; i += 2)                                              \
+        _mm_storeu_pd(a + i, INTRIN(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i))); \
+    for( ; i < n; i++)                                                      \
+        a[i] OP b[i];                                                       \
+}
+DOUBLE_KERNEL(add_block, _mm_add_pd, +=)
+DOUBLE_KERNEL(sub_block, _mm_sub_pd, -=)
+DOUBLE_KERNEL(mul_block, _mm_mul_pd, *=)
+DOUBLE_KERNEL(div_block, _mm_div_pd, /=)
+#undef DOUBLE_KERNEL
+#endif
+
+#if defined(__AVX2__)
+// 8 ints per step
+#define INT_KERNEL(NAME, INTRIN, OP)                                        \
+template <> void NAME<int>(int* a, const int* b, int n)                     \
+{                                                                           \
+    int i = 0;                                                              \
+    for( ; i + 8 <= n; i += 8)                                              \
+        _mm256_storeu_si256((__m256i*)(a + i), INTRIN(_mm256_loadu_si256((const __m256i*)(a + i)), \
+                                                      _mm256_loadu_si256((const __m256i*)(b + i)))); \
+    for( ; i < n; i++)                                                      \
+        a[i] OP b[i];                                                       \
+}
+INT_KERNEL(add_block, _mm256_add_epi32, +=)
+INT_KERNEL(sub_block, _mm256_sub_epi32, -=)
+INT_KERNEL(mul_block, _mm256_mullo_epi32, *=)
+#undef INT_KERNEL
+#elif defined(__SSE2__)
+// 4 ints per step (SSE2 has no 32-bit multiply, that is left to the generic loop)
+#define INT_KERNEL(NAME, INTRIN, OP)                                        \
+template <> void NAME<int>(int* a, const int* b, int n)                     \
+{                                                                           \
+    int i = 0;                                                              \
+    for( ; i + 4 <= n; i += 4)                                              \
+        _mm_storeu_si128((__m128i*)(a + i), INTRIN(_mm_loadu_si128((const __m128i*)(a + i)), \
+                                                   _mm_loadu_si128((const __m128i*)(b + i)))); \
+    for( ; i < n; i++)                                                      \
+        a[i] OP b[i];                                                       \
+}
+INT_KERNEL(add_block, _mm_add_epi32, +=)
+INT_KERNEL(sub_block, _mm_sub_epi32, -=)
+#undef INT_KERNEL
+#endif
+
+
+// cols[0] is the column of 'a', cols[1] the column of 'b', ...; out receives nRows results
+// (returns false, with *err set, at the first block with a bad int division: the rows from that block on are not set)
+template <class T>
+bool ExprProgram::run_batch(const T* const* cols, int nRows, T* out, const char** err) const
+{
+    vector<T> st((depth + nSlots) * BLOCK);     // one block of values per stack entry and per slot (allocated once per call)
+    T* base = st.data();
+    T* slots = base + depth * BLOCK;
+
+    for(int row = 0; row < nRows; row += BLOCK)
+    {
+        int n = (nRows - row < BLOCK) ? nRows - row : BLOCK;
+        T* top = base - BLOCK;          // the block on top of the stack
+
+        for(const Instr* pc = code.data(); pc != code.data() + code.size(); pc++)
+        {
+            switch(pc->op)
+            {
+            case OP_CONST:
+                top += BLOCK;
+                for(int i = 0; i < n; i++) top[i] = pc->arg;
+                break;
+            case OP_VAR:
+                top += BLOCK;
+                copy(cols[pc->arg] + row, cols[pc->arg] + row + n, top);
+                break;
+            case OP_ADD: top -= BLOCK; add_block(top, top + BLOCK, n); break;
+            case OP_SUB: top -= BLOCK; sub_block(top, top + BLOCK, n); break;
+            case OP_MUL: top -= BLOCK; mul_block(top, top + BLOCK, n); break;
+            case OP_DIV:
+                top -= BLOCK;
+                if(numeric_limits<T>::is_integer)   // (checked first: the kernel itself can't stop half way)
+                {
+                    for(int i = 0; i < n; i++)
+                        if(const char* e = division_error(top[i], top[BLOCK + i]))
+                        {   if(err) *err = e; return false; }
+                }
+                div_block(top, top + BLOCK, n);
+                break;
+            case OP_NEG: for(int i = 0; i < n; i++) top[i] = -top[i]; break;
+            case OP_SAVE: copy(top, top + n, slots + pc->arg * BLOCK); break;
+            case OP_LOAD:
+                top += BLOCK;
+                copy(slots + pc->arg * BLOCK, slots + pc->arg * BLOCK + n, top);
+                break;
+            }
+        }
+        copy(top, top + n, out + row);
+    }
+    if(err) *err = NULL;
+    return true;
+}
+/* Note:
+    Constant folding never folds a division by 0 (see emit()), so 1/0 is compiled as it is,
+        and it is run() / run_batch() that catch it: an 'int' division by 0 or INT_MIN / -1 is an error for that row,
+        while a 'double' division follows the floating point rules (1.0/0 is inf, 0.0/0 is nan).
+*/
+
+
+///* A Cache of Recently Used Formulas ..................................................:
+/*
+    When the same formulas arrive again and again (the same report lines, the same user inputs),
+    there is no need to compile and evaluate them every time:
+        • The text is first 'normalized' (spaces and leading zeros are dropped, 007 becomes 7),
+            so "2 + 3" and "2+3" are recognized as the same formula.
+        • The normalized text is the key of a hash table that finds the cached entry in O(1).
+        • A constant formula stores its result, a formula with variables stores its compiled program.
+        • The cache holds at most 'capacity' entries. The entries are kept in a linked list in the order of their last use,
+            and when the cache is full, the least recently used (LRU) one is thrown away.
+    The hit/miss counters show how often a formula was found in the cache.
+    ► Many threads can share one cache: the lock is held only to find or insert an entry.
+        An entry's compiled formula never changes after it is made, and the entry holds it through a shared_ptr,
+        so a thread keeps its own shared_ptr and compiles or runs the formula after letting go of the lock,
+        even if another thread evicts the entry meanwhile.
+*/
+class ExprCache
+{
+private:
+    struct Formula                      // (const once compiled)
+    {
+        ExprProgram prog;
+        const char* err;                // why it can't be evaluated (a compile error, or 1/0 in a constant formula), or NULL
+        int value;                      // the result of a constant formula
+    };
+    struct Entry
+    {
+        string key;
+        shared_ptr<const Formula> formula;
+    };
+    size_t capacity;
+    list<Entry> entries;                // most recently used first
+    unordered_map<string, list<Entry>::iterator> index;
+    long nHits, nMisses, nEvictions;
+    mutable mutex lock;                 // guards the list, the index and the counters (not the formulas)
+    ExprCache(const ExprCache&);
+    ExprCache& operator = (const ExprCache&);
+public:
+    ExprCache(size_t cap = 1024) : capacity(cap), nHits(0), nMisses(0), nEvictions(0)
+    {   }
+    // returns false (with a message in 'err') for a malformed formula; 'vars' are needed only by formulas with variables
+    bool evaluate(const char* first, const char* last, int& result, const char*& err, const int* vars = NULL);
+    long hits() const
+    {   lock_guard<mutex> guard(lock); return nHits; }
+    long misses() const
+    {   lock_guard<mutex> guard(lock); return nMisses; }
+    long evictions() const
+    {   lock_guard<mutex> guard(lock); return nEvictions; }
+};
+
+// copies [first, last) into 'key' without spaces and leading zeros, so "2 + 03" and "2+3" give the same key
+static void normalize(const char* first, const char* last, string& key)
+{
+    char prev = 0;                      // the last character copied
+    bool skipped = false;               // spaces were skipped after it
+    key.clear();
+    for( ; first != last && *first; first++)
+    {
+        char ch = *first;
+        bool digit = (ch >= '0' && ch <= '9');
+        if(ch == ' ')
+        {   skipped = true; continue; }
+        if(digit && skipped && prev >= '0' && prev <= '9')
+            key += ' ';                 // "1 2" must stay two numbers (and an error)
+        else if(ch == '0' && !(prev >= '0' && prev <= '9' && !skipped)
+                && first + 1 != last && first[1] >= '0' && first[1] <= '9')
+            continue;                   // a leading zero
+        key += ch;
+        prev = ch;
+        skipped = false;
+    }
+}
+
+bool ExprCache::evaluate(const char* first, const char* last, int& result, const char*& err, const int* vars)
+{
+    static thread_local string key;     // keeps its memory from one call to the next
+    normalize(first, last, key);
+
+    shared_ptr<const Formula> formula;
+    {
+        lock_guard<mutex> guard(lock);
+        unordered_map<string, list<Entry>::iterator>::iterator found = index.find(key);
+        if(found != index.end())
+        {
+            nHits++;
+            entries.splice(entries.begin(), entries, found->second);   // move it to the front (most recently used)
+            formula = found->second->formula;
+        }
+        else
+            nMisses++;
+    }
+
+    if(!formula)                        // compiled without the lock: the other threads keep using the cache
+    {
+        shared_ptr<Formula> f = make_shared<Formula>();
+        f->err = f->prog.compile(key.c_str()) ? NULL : f->prog.error();
+        f->value = (f->err == NULL && f->prog.vars_used() == 0) ? f->prog.run(&f->err) : 0;
+        formula = f;
+
+        lock_guard<mutex> guard(lock);
+        if(index.find(key) == index.end())      // (another thread may have added it meanwhile)
+        {
+            if(entries.size() >= capacity && !entries.empty())
+            {
+                index.erase(entries.back().key);                        // evict the least recently used entry,
+                entries.splice(entries.begin(), entries, --entries.end());  // and reuse its node (and its memory)
+                nEvictions++;
+            }
+            else
+                entries.push_front(Entry());
+            entries.front().key = key;
+            entries.front().formula = formula;
+            index[key] = entries.begin();
+        }
+    }
+
+    if(formula->err)
+    {   err = formula->err; return false; }
+    if(formula->prog.vars_used() == 0)
+        result = formula->value;        // memoized: not evaluated again
+    else if(vars == NULL)
+    {   err = "variables have no values"; return false; }
+    else
+    {
+        const char* runErr;
+        result = formula->prog.run(vars, &runErr);
+        if(runErr)
+        {   err = runErr; return false; }
+    }
+    return true;
+}
+
+
+///* Sorting Library ...................................................................:
+/*
+    The bubble sorts (at the end of this file) compare every pair of items: O(n²) comparisons.
+        For a million items that is about 5 * 10^11 comparisons, which is hours of work.
+
+    ► Introsort (introspective sort) does the same job in O(n log n):
+        • Quicksort: choose a 'pivot' (the median of the first, middle and last items),
+            put the smaller items before it and the bigger ones after it, and sort the two parts the same way.
+        • Heapsort: quicksort becomes O(n²) if the pivots keep being bad, 
+            so when the parts are split more than 2*log2(n) times, that part is finished with heapsort (always O(n log n)).
+        • Insertion sort: for the small parts (SMALL_SORT items or less) the simple insertion sort is the fastest.
     
-    // allocating a single object
-    float * pFloat = new float;     // note that this var has name, only a pointer to it.
-    delete pFloat;
+    The templates work for any Type with the < operator (int, double, string, ...),
+        and items are moved (not copied) around, which matters for Types like 'string'.
+*/
+const int SMALL_SORT = 16;              // parts this small are finished by small_sort() (see small_sort_limit())
+
+template <class T>
+void insertion_sort(T* first, T* last)
+{
+    for(T* i = first + 1; i < last; i++)
+    {
+        T val = move(*i);
+        T* j = i;
+        for( ; j > first && val < *(j - 1); j--)    // shift the bigger items one place to the right
+            *j = move(*(j - 1));
+        *j = move(val);
+    }
+}
+
+// the base case of the bigger sorts (overloaded for the Types that have a faster way)
+template <class T>
+void small_sort(T* first, T* last)
+{   insertion_sort(first, last); }
+
+template <class T>
+int small_sort_limit(const T*)          // the biggest part intro_sort() hands to small_sort()
+{   return SMALL_SORT; }
+
+///* Sorting Networks for Small int Blocks ..............................................:
+/*
+    A sorting network is a fixed sequence of compare-exchanges (put the smaller of two items first),
+        chosen so that the items come out sorted whatever they were; there are no branches that depend on the data.
+    ► With AVX2, one register holds 8 ints, and _mm256_min_epi32()/_mm256_max_epi32() compare-exchange 8 pairs at once:
+        • sort8(): a bitonic network sorts the 8 ints of one register in 6 steps
+            (each step pairs every lane with another one, and keeps the min or the max of the pair.)
+        • merge_runs(): two sorted runs of registers are merged by reversing the second run 
+            (together they go up and then down: a 'bitonic' sequence), then compare-exchanging registers 
+            half the length apart, a quarter apart, ..., and finally the lanes inside every register.
+        • sort_block<R>(): sorts 8*R ints (8, 16, 32 or 64) with sort8() on every register, then merge_runs().
+    ► Without AVX2, the same networks run on SSE2 registers of 4 ints (SSE2 is always there on x86-64):
+        SSE2 has no 32-bit min/max (_mm_min_epi32() is SSE4.1), so they are a _mm_cmpgt_epi32() mask and a blend.
+    ► With no SIMD at all, sort_block<R>() is the same bitonic network on plain ints, one pair at a time
+        (min() and max() compile to conditional moves, so it has no data-dependent branches either.)
+    network_sort() sorts up to NETWORK_MAX ints: it pads them up to the next block size with INT_MAX.
+    It is the small_sort() for ints on every path, so intro_sort(), radix_sort() (under its cutoff) and parallel_sort() all use it.
+*/
+#if defined(__AVX2__)
+const int NETWORK_LANES = 8;                           // ints in one register
+
+static inline void cmpx(__m256i& a, __m256i& b)         // a = min(a, b), b = max(a, b) in all 8 lanes
+{
+    __m256i t = _mm256_min_epi32(a, b);
+    b = _mm256_max_epi32(a, b);
+    a = t;
+}
+
+// one step of a bitonic network: lane i meets lane i^J, and the lanes with a 1 bit in KEEP_MAX keep the bigger int
+template <int J, int KEEP_MAX>
+static inline __m256i bitonic_step(__m256i v)
+{
+    __m256i other = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0 ^ J, 1 ^ J, 2 ^ J, 3 ^ J, 4 ^ J, 5 ^ J, 6 ^ J, 7 ^ J));
+    return _mm256_blend_epi32(_mm256_min_epi32(v, other), _mm256_max_epi32(v, other), KEEP_MAX);
+}
+
+static inline __m256i merge8(__m256i v)                 // sorts a bitonic register
+{   return bitonic_step<1, 0xAA>(bitonic_step<2, 0xCC>(bitonic_step<4, 0xF0>(v))); }
+
+static inline __m256i sort8(__m256i v)                  // sorts any register
+{   return merge8(bitonic_step<1, 0x5A>(bitonic_step<2, 0x3C>(bitonic_step<1, 0x66>(v)))); }
+
+static inline __m256i reverse8(__m256i v)
+{   return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)); }
+
+// v[0 .. w) and v[w .. 2w) are sorted runs of registers: merges them into one sorted run
+static inline void merge_runs(__m256i* v, int w)
+{
+    for(int i = 0; i < w / 2; i++)                      // reverse the second run (its registers, then their lanes)
+        swap(v[w + i], v[2 * w - 1 - i]);
+    for(int i = w; i < 2 * w; i++)
+        v[i] = reverse8(v[i]);
+    for(int d = w; d >= 1; d /= 2)                      // compare registers d apart
+        for(int i = 0; i < 2 * w; i++)
+            if((i & d) == 0)
+                cmpx(v[i], v[i + d]);
+    for(int i = 0; i < 2 * w; i++)                      // and finally the lanes inside every register
+        v[i] = merge8(v[i]);
+}
+
+template <int R>
+void sort_block(int* p)                                 // sorts 8*R ints (R = 1, 2, 4 or 8)
+{
+    __m256i v[R];
+    for(int i = 0; i < R; i++)
+        v[i] = sort8(_mm256_loadu_si256((const __m256i*)(p + 8 * i)));
+    for(int w = 1; w < R; w *= 2)
+        for(int s = 0; s < R; s += 2 * w)
+            merge_runs(v + s, w);
+    for(int i = 0; i < R; i++)
+        _mm256_storeu_si256((__m256i*)(p + 8 * i), v[i]);
+}
+
+#elif defined(__SSE2__)
+const int NETWORK_LANES = 4;
+
+static inline __m128i select4(__m128i mask, __m128i a, __m128i b)   // a in the lanes where mask is set, b in the others
+{   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+
+#if defined(__SSE4_1__)
+static inline __m128i min4(__m128i a, __m128i b) {   return _mm_min_epi32(a, b); }
+static inline __m128i max4(__m128i a, __m128i b) {   return _mm_max_epi32(a, b); }
+#else
+static inline __m128i min4(__m128i a, __m128i b) {   return select4(_mm_cmpgt_epi32(a, b), b, a); }
+static inline __m128i max4(__m128i a, __m128i b) {   return select4(_mm_cmpgt_epi32(a, b), a, b); }
+#endif
+
+static inline void cmpx(__m128i& a, __m128i& b)         // a = min(a, b), b = max(a, b) in all 4 lanes
+{
+    __m128i t = min4(a, b);
+    b = max4(a, b);
+    a = t;
+}
+
+// one step of a bitonic network: lane i meets lane i^J, and the lanes with a 1 bit in KEEP_MAX keep the bigger int
+template <int J, int KEEP_MAX>
+static inline __m128i bitonic_step(__m128i v)
+{
+    __m128i other = _mm_shuffle_epi32(v, J == 1 ? _MM_SHUFFLE(2, 3, 0, 1) : _MM_SHUFFLE(1, 0, 3, 2));
+    __m128i keep = _mm_setr_epi32(-(KEEP_MAX & 1), -(KEEP_MAX >> 1 & 1), -(KEEP_MAX >> 2 & 1), -(KEEP_MAX >> 3 & 1));
+    return select4(keep, max4(v, other), min4(v, other));
+}
+
+static inline __m128i merge4(__m128i v)                 // sorts a bitonic register
+{   return bitonic_step<1, 0xA>(bitonic_step<2, 0xC>(v)); }
+
+static inline __m128i sort4(__m128i v)                  // sorts any register
+{   return merge4(bitonic_step<1, 0x6>(v)); }
+
+static inline __m128i reverse4(__m128i v)
+{   return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)); }
+
+// v[0 .. w) and v[w .. 2w) are sorted runs of registers: merges them into one sorted run
+static inline void merge_runs(__m128i* v, int w)
+{
+    for(int i = 0; i < w / 2; i++)                      // reverse the second run (its registers, then their lanes)
+        swap(v[w + i], v[2 * w - 1 - i]);
+    for(int i = w; i < 2 * w; i++)
+        v[i] = reverse4(v[i]);
+    for(int d = w; d >= 1; d /= 2)                      // compare registers d apart
+        for(int i = 0; i < 2 * w; i++)
+            if((i & d) == 0)
+                cmpx(v[i], v[i + d]);
+    for(int i = 0; i < 2 * w; i++)                      // and finally the lanes inside every register
+        v[i] = merge4(v[i]);
+}
+
+template <int R>
+void sort_block(int* p)                                 // sorts 4*R ints (R = 1, 2, 4, 8 or 16)
+{
+    __m128i v[R];
+    for(int i = 0; i < R; i++)
+        v[i] = sort4(_mm_loadu_si128((const __m128i*)(p + 4 * i)));
+    for(int w = 1; w < R; w *= 2)
+        for(int s = 0; s < R; s += 2 * w)
+            merge_runs(v + s, w);
+    for(int i = 0; i < R; i++)
+        _mm_storeu_si128((__m128i*)(p + 4 * i), v[i]);
+}
+
+#else
+const int NETWORK_LANES = 1;
+
+template <int R>
+void sort_block(int* p)                                 // sorts R ints (R = 1, 2, 4, ..., 64)
+{
+    for(int k = 2; k <= R; k *= 2)                      // sorted runs of k/2 become bitonic runs of k, then sorted
+        for(int j = k / 2; j >= 1; j /= 2)              // compare the ints j apart
+            for(int i = 0; i < R; i++)
+            {
+                int l = i ^ j;
+                if(l > i)                               // (depends on the indices only, not on the data)
+                {
+                    int lo = min(p[i], p[l]), hi = max(p[i], p[l]);
+                    bool up = (i & k) == 0;             // the runs go up and down in turn
+                    p[i] = up ? lo : hi;
+                    p[l] = up ? hi : lo;
+                }
+            }
+}
+#endif
+
+const int NETWORK_MAX = 64;
+
+void network_sort(int* first, int* last)                // up to NETWORK_MAX ints
+{
+    int n = last - first;
+    int block = NETWORK_LANES;
+    while(block < n)
+        block *= 2;
+    int buf[NETWORK_MAX];
+    int* p = first;
+    if(n != block)                                      // pad with INT_MAX (it sorts to the end)
+    {
+        copy(first, last, buf);
+        fill(buf + n, buf + block, INT_MAX);
+        p = buf;
+    }
+    switch(block / NETWORK_LANES)                       // registers (or ints) in the block
+    {
+    case 1:  sort_block<1>(p); break;
+    case 2:  sort_block<2>(p); break;
+    case 4:  sort_block<4>(p); break;
+    case 8:  sort_block<8>(p); break;
+    case 16: sort_block<16>(p); break;
+    case 32: sort_block<32>(p); break;
+    default: sort_block<NETWORK_MAX / NETWORK_LANES>(p); break;
+    }
+    if(p == buf)
+        copy(buf, buf + n, first);
+}
+
+inline void small_sort(int* first, int* last)           // (chosen over the template for int arrays)
+{
+    if(last - first <= NETWORK_MAX)
+        network_sort(first, last);
+    else
+        insertion_sort(first, last);
+}
+
+inline int small_sort_limit(const int*)                 // intro_sort() hands ints to small_sort() in parts up to this size
+{   return NETWORK_MAX; }
+
+
+template <class T>
+void sift_down(T* heap, long i, long n) // moves heap[i] down until both its children are smaller
+{
+    T val = move(heap[i]);
+    for(long child = 2 * i + 1; child < n; child = 2 * i + 1)
+    {
+        if(child + 1 < n && heap[child] < heap[child + 1])
+            child++;
+        if(!(val < heap[child]))
+            break;
+        heap[i] = move(heap[child]);
+        i = child;
+    }
+    heap[i] = move(val);
+}
+
+template <class T>
+void heap_sort(T* first, T* last)
+{
+    long n = last - first;
+    for(long i = n / 2 - 1; i >= 0; i--)    // build a max-heap
+        sift_down(first, i, n);
+    for(long end = n - 1; end > 0; end--)   // move the biggest to the end, and repair the heap
+    {
+        swap(first[0], first[end]);
+        sift_down(first, 0, end);
+    }
+}
+
+template <class T>
+void median_to_first(T* first, T* a, T* b, T* c)    // puts the median of *a, *b, *c into *first
+{
+    if(*a < *b)
+    {
+        if(*b < *c)      swap(*first, *b);
+        else if(*a < *c) swap(*first, *c);
+        else             swap(*first, *a);
+    }
+    else if(*a < *c)     swap(*first, *a);
+    else if(*b < *c)     swap(*first, *c);
+    else                 swap(*first, *b);
+}
+
+// Hoare partition of [first, last) around 'pivot': returns where the bigger part starts
+// (no bounds checks are needed: the median-of-three leaves an item <= pivot and one >= pivot at the two ends)
+template <class T>
+T* partition_around(T* first, T* last, const T& pivot)
+{
+    while(true)
+    {
+        while(*first < pivot)
+            first++;
+        last--;
+        while(pivot < *last)
+            last--;
+        if(!(first < last))
+            return first;
+        swap(*first, *last);            // (std::swap: first and last are never the same item here)
+        first++;
+    }
+}
+
+template <class T>
+void intro_sort_loop(T* first, T* last, int depthLimit)
+{
+    while(last - first > small_sort_limit(first))
+    {
+        if(depthLimit-- == 0)
+        {   heap_sort(first, last); return; }
+
+        median_to_first(first, first + 1, first + (last - first) / 2, last - 1);
+        T* cut = partition_around(first + 1, last, *first);
+
+        // recurse into the smaller part and loop on the bigger one: the recursion is never deeper than log2(n)
+        if(cut - first < last - cut)
+        {   intro_sort_loop(first, cut, depthLimit); first = cut; }
+        else
+        {   intro_sort_loop(cut, last, depthLimit); last = cut; }
+    }
+    if(last - first > 1)
+        small_sort(first, last);
+}
+
+template <class T>
+void intro_sort(T* first, T* last)
+{
+    int depthLimit = 0;
+    for(long n = last - first; n > 1; n >>= 1)
+        depthLimit += 2;
+    intro_sort_loop(first, last, depthLimit);
+}
+
+template <class T>
+void intro_sort(T* arr, long n)         // the same (array, size) shape as the bubble sorts (long: like parallel_sort())
+{   intro_sort(arr, arr + n); }
+
+
+///* Radix Sort for ints ...............................................................:
+/*
+    Sorting ints doesn't need comparisons at all.
+    ► LSD (least significant digit first) radix sort:
+        An int is seen as 3 'digits' of 11 bits (11 + 11 + 10 bits), and the array is distributed by one digit at a time,
+            starting with the lowest one, into 2048 'buckets' (one for every value of the digit.)
+        • Every pass is stable (items with the same digit keep their order), 
+            so after the pass on the highest digit, the array is sorted by all the digits.
+        • One pass counts how many items fall in each bucket (for all the 3 digits at once),
+            then each digit's pass moves the items straight to their places: 
+            3 passes over the array, whatever its size: O(n).
+        • A pass in which all the items have the same digit would change nothing, so it is skipped.
+        • Negative ints: flipping the sign bit makes the bits of a negative int sort before those of a positive one.
+        • The items move between the array and a scratch array of the same size, 
+            which the RadixSorter keeps from one sort() to the next (so it is allocated only once.)
+    For small arrays the counting costs more than it saves, so below 'cutoff' items sort() calls intro_sort().
+*/
+const int RADIX_CUTOFF = 512;           // (about the crossover measured by the radix sort benchmark)
+
+class RadixSorter
+{
+private:
+    static const int BITS = 11;
+    static const int BUCKETS = 1 << BITS;
+    static const int PASSES = 3;
+    static const unsigned SIGN = 0x80000000u;
+    vector<int> scratch;                // reused by every sort()
+    unsigned count[PASSES][BUCKETS];
+    int cutoff;
+public:
+    RadixSorter(int minItems = RADIX_CUTOFF) : cutoff(minItems)
+    {   }
+    void sort(int* arr, int n);
+};
+
+void RadixSorter::sort(int* arr, int n)
+{
+    if(n < cutoff || n < 2)
+    {   intro_sort(arr, n); return; }
+    if(int(scratch.size()) < n)
+        scratch.resize(n);
+
+    memset(count, 0, sizeof(count));
+    for(int i = 0; i < n; i++)          // the histograms of all the digits, in one pass
+    {
+        unsigned key = unsigned(arr[i]) ^ SIGN;
+        count[0][key & (BUCKETS - 1)]++;
+        count[1][(key >> BITS) & (BUCKETS - 1)]++;
+        count[2][key >> (2 * BITS)]++;
+    }
+
+    int* src = arr;
+    int* dst = scratch.data();
+    for(int pass = 0; pass < PASSES; pass++)
+    {
+        int shift = pass * BITS;
+        unsigned* offset = count[pass];
+        if(offset[((unsigned(src[0]) ^ SIGN) >> shift) & (BUCKETS - 1)] == unsigned(n))
+            continue;                   // every item has the same digit
+
+        unsigned sum = 0;               // turn the counts into the start of every bucket
+        for(int b = 0; b < BUCKETS; b++)
+        {
+            unsigned c = offset[b];
+            offset[b] = sum;
+            sum += c;
+        }
+        for(int i = 0; i < n; i++)
+        {
+            unsigned digit = ((unsigned(src[i]) ^ SIGN) >> shift) & (BUCKETS - 1);
+            dst[offset[digit]++] = src[i];
+        }
+        swap(src, dst);
+    }
+    if(src != arr)                      // an odd number of passes left the result in the scratch array
+        memcpy(arr, src, n * sizeof(int));
+}
+
+void radix_sort(int* arr, int n)        // the same (int*, int) shape as the other sorts
+{
+    static RadixSorter sorter;
+    sorter.sort(arr, n);
+}
+/* Note:
+    radix_sort() shares one RadixSorter (and its scratch array) between all its calls, so it is not for many threads at once;
+        give each thread its own RadixSorter instead.
+*/
+
+
+///* Parallel Sort .....................................................................:
+/*
+    All the sorts above use only one core. parallel_sort() splits the work between nThreads threads:
+        1. The array is cut into nThreads 'runs', and each thread sorts its run (with intro_sort).
+        2. Splitters: every run gives nThreads-1 evenly spaced samples; the samples are sorted and 
+            nThreads-1 of them are chosen as splitters. Every run is then cut at the splitters (by binary search),
+            so that part j of every run holds only items between splitter j-1 and splitter j.
+            Equal items are told apart by their place in the array (a sample is an (item, position) pair),
+            so a long run of equal keys is cut between several parts too, instead of all going to one thread.
+            (This is 'sorting by regular sampling': no thread ends up with more than about twice its fair share.)
+        3. Multiway merge: thread j merges part j of all the runs at once (a small heap picks the smallest head item),
+            straight into its place in a scratch array,
+        4. and when all the merges are done, copies it back.
+    The threads never touch the same items, so they need no locks; they only wait for each other between the steps.
+*/
+template <class T>
+void multiway_merge(vector<pair<T*, T*> >& parts, T* out)   // merges sorted [first, last) parts into out
+{
+    vector<int> heap;                   // the parts that still have items, the smallest head item on top
+    for(size_t i = 0; i < parts.size(); i++)
+        if(parts[i].first != parts[i].second)
+            heap.push_back(int(i));
+    auto greater = [&](int a, int b) { return *parts[b].first < *parts[a].first; };
+    make_heap(heap.begin(), heap.end(), greater);
+
+    while(!heap.empty())
+    {
+        pop_heap(heap.begin(), heap.end(), greater);
+        pair<T*, T*>& top = parts[heap.back()];
+        *out++ = move(*top.first++);
+        if(top.first == top.second)
+            heap.pop_back();
+        else
+            push_heap(heap.begin(), heap.end(), greater);
+    }
+}
+
+template <class T>
+void parallel_sort(T* arr, long n, int nThreads = 0)    // nThreads = 0: one thread per core
+{
+    const long MIN_RUN = 1 << 16;       // fewer items per thread are not worth starting a thread for
+    if(nThreads <= 0)
+        nThreads = thread::hardware_concurrency();
+    if(nThreads > n / MIN_RUN)
+        nThreads = int(n / MIN_RUN);
+    if(nThreads <= 1)
+    {   intro_sort(arr, arr + n); return; }
+
+    // 1. sort the runs
+    vector<T*> runs(nThreads + 1);      // run i is [runs[i], runs[i+1])
+    for(int i = 0; i <= nThreads; i++)
+        runs[i] = arr + n * i / nThreads;
+    vector<thread> threads;
+    for(int i = 0; i < nThreads; i++)
+        threads.push_back(thread([&, i]() { intro_sort(runs[i], runs[i + 1]); }));
+    for(int i = 0; i < nThreads; i++)
+        threads[i].join();
+    threads.clear();
+
+    // 2. choose the splitters and cut every run at them
+    vector<pair<T, long> > samples;     // (item, position): sorted by item, then by position
+    for(int i = 0; i < nThreads; i++)
+        for(int j = 1; j < nThreads; j++)
+        {
+            long pos = (runs[i] - arr) + (runs[i + 1] - runs[i]) * j / nThreads;
+            samples.push_back(make_pair(arr[pos], pos));
+        }
+    intro_sort(samples.data(), samples.data() + samples.size());
+
+    vector< vector<T*> > cut(nThreads, vector<T*>(nThreads + 1));  // cut[i][j]: where part j of run i starts
+    for(int i = 0; i < nThreads; i++)
+    {
+        cut[i][0] = runs[i];
+        cut[i][nThreads] = runs[i + 1];
+        for(int j = 1; j < nThreads; j++)
+        {
+            const pair<T, long>& splitter = samples[samples.size() * j / nThreads];
+            T* lo = lower_bound(cut[i][j - 1], runs[i + 1], splitter.first);
+            T* hi = upper_bound(lo, runs[i + 1], splitter.first);
+            // the items equal to the splitter before its position go to part j-1, the others to part j
+            T* at = arr + splitter.second;
+            cut[i][j] = (at < lo) ? lo : (at > hi) ? hi : at;
+        }
+    }
+
+    // 3. merge part j of every run into its place in the scratch array
+    T* scratch = new T[n];              // (not a vector: that would fill it with zeros first, on one thread)
+    vector<long> start(nThreads + 1, 0);    // part j of the result is [start[j], start[j+1])
+    for(int j = 0; j < nThreads; j++)
+        for(int i = 0; i < nThreads; i++)
+            start[j + 1] += cut[i][j + 1] - runs[i];
+    for(int j = 0; j < nThreads; j++)
+        threads.push_back(thread([&, j]()
+        {
+            vector<pair<T*, T*> > parts;
+            for(int i = 0; i < nThreads; i++)
+                parts.push_back(make_pair(cut[i][j], cut[i][j + 1]));
+            multiway_merge(parts, scratch + start[j]);
+        }));
+    for(int j = 0; j < nThreads; j++)
+        threads[j].join();
+    threads.clear();
+
+    // 4. copy it back (only now: until every merge is done, the runs in 'arr' are still being read)
+    for(int j = 0; j < nThreads; j++)
+        threads.push_back(thread([&, j]() { move(scratch + start[j], scratch + start[j + 1], arr + start[j]); }));
+    for(int j = 0; j < nThreads; j++)
+        threads[j].join();
+    delete[] scratch;
+}
+
+    
+////////////////////////////////////////////////////////////////////////////////////////
+// main()
+#if 1
+int main()
+{
+    int v1 = 26;
+    cout << &v1 << endl;        // & var : address of var
+
+    int* ptr = &v1;             // int * : a pointer to int
+    cout << ptr << endl;
+    cout << *ptr << endl;       // * ptr : dereference ptr 
+
+    char *ptr1, *ptr2, *ptr3;   // defining multible pointers on the same line
+
+    int v2 = *ptr;
+    cout << v2 << endl;
+
+    /* Note:
+        The pointer must be given some value, or it will point to an addresss we don't want it to point to.
+        >> Rogue pointer values can result in system crashes and are difficult to debug.
+        So, Make sure you give every pointer variable a valid address value before using it (ex.: NULL).
+    */
+
+    ///* To assign one kind of pointer type to another ................................:
+    float flovar = 98.6;
+    // int* ptrint = &flovar;   //ERROR: can't assign float* to int*
+    int *ptrint = reinterpret_cast<int*>(&flovar); 
+    // Static casts won't work with pointers. 
+    // Old-style C casts can be used, but are always a bad idea in C++.
+
+
+    ///* void pointers ................................................................:
+    void *vptr;     // vptr can point to any data type.
+                    // • Can be used to pass pointers to functions that operate
+                    //   independently of the data type pointed to.
+    int ivar;
+    float fvar;
+    vptr = &ivar;   // Ok
+    vptr = &fvar;   // Ok
+    
+
+    ///* A capsule summary ...........................................................:
+    int v;      // defines variable v of type int
+    float f;    // defines variable f of type float
+    int* p;     // defines p as a pointer to int
+    p = &v;     // assigns address of variable v to pointer p
+    v = 3;      // assigns 3 to v
+    *p = 3;     // also assigns 3 to v
+    void* vp;   // defines vp as a pointer to void 
+    vp = &v;    // assigns address of variable v to pointer vp
+    vp = &f;    // assigns address of variable f to pointer vp
+    p = reinterpret_cast<int*>(&f);     // assigns address of float variable f to the pointer to int p
+
+    
+    ///* Pointers and Arrays .........................................................:
+    int i;
+    int intArr[5] = {56, 62, 96, 45, 12};                   // Note: the address of an array is always a constant.
+    for (i = 0; i < 5; i++)
+    {   cout << endl << *(intArr + i); } cout << endl;      // the name of an array is its address
+    // The C++ compiler is smart enough (using the pointer type) to take the size of the data into account when
+    //   it performs arithmetic on data addresses (here it increments by the size of int.)
+    /* Note:
+        Array name is a pointer constant (a non-modifiable lvalue) NOT a pointer variable,
+        Which means that it is the address where the system has chosen to place your array.
+        intArr++;  is like  0x36466631++;
+        But intArr[i] is an lvalue because, it is: *(intArr + i)
+    */
+
+    int *iArrptr = intArr;
+    for (i = 0; i < 5; i++)
+    {   cout << endl << *(iArrptr++); } cout << endl;
+    // because iArrptr is a variable and not a constant, it can be incremented. 
+
+    
+    ///* Passing by pointer ..........................................................:
+    void centimize(double*);
+    
+    double dist = 10.0;     // in inches
+    cout << "\ndist = " << dist << " inches" << endl;
+    
+    centimize(&dist);
+    cout << "dist = " << dist << " centimeters" << endl;
+    
+
+    ///* Passing Arrays ..............................................................:
+    void centimizeArr(double*);
+    
+    double dblArr[MAX] = {10.0, 43.1, 95.9, 59.7, 87.3};
+    centimizeArr(dblArr);
+    
+    for ( i = 0; i < MAX; i++)
+    {   cout << "\ndblArr[" << i << "] = " << dblArr[i] << " cm"; } cout << endl;
+    
+
+    ///* Array Bubble Sort ............................................................:
+    void BubbleSort(int *, int);
+    int intArr2[MAX] = {61, 46, 49, 32, 64};
+    BubbleSort(intArr2, MAX);
+    
+    for (i = 0; i < MAX; i++)
+    {   cout << endl << intArr2[i]; } cout << endl;
+    
+
+    ///* Pointers to string ..........................................................:
+    char str1[] = "Defined as an array";            // A string constant can be defined as an array or as a pointer. 
+    char *str2 = (char*)"Defined as a pointer";     // The pointer approach may be more flexible, 
+                                                    //  → but there is a danger that the pointer value will be corrupted.
+    cout << str1 << endl;
+    cout << str2 << endl;
+    
+    //  str1++;         // can't do this; str1 is a constant
+        str2++;         // this is ok, str2 is a pointer
+
+    void dispStr(char*);
+    dispStr(str1);
+    dispStr(str2);
+
+    void cpyStr(char*, const char*);
+    char *str3 = (char*)"Self-conquest is the greatest victory.";
+    char str4[50];
+    cpyStr(str4, str3);
+    cout << str4 << endl;
+
+    
+    ///* const modifiers and pointers ................................................:
+    const int ciVar = 4;
+    int iVar = 5;
+    
+    /// pointer to const int:
+    const int * pcInt;                  // pointer to const int
+    int const * pcInt2;                 // same thing ...
+    pcInt = &ciVar;                     // points to const int
+    pcInt = &iVar;                      // points to int
+    ivar = 6;                           // ivar value stll can be changed (it's stll int not const int)
+    // 'const int' must be pointed to by (pointers to const int),
+    //  while 'int' can be pointed to by either a (ptr to int) or a (ptr to const int [here it does not mean that the var int cannot be changed].)
+    
+    /// const pointer to int:
+    int * const cpInt = &iVar;          // (const pointer) to int (you cannot change the value of the pointer.)
+    // int * const cpInt2 = &ciVar;     // Error: cannot point to const int
+    // cpInt = &v1;                     // Error: you cannot change const ptr value 
+
+    /// const pointer to const int:
+    const int * const cpcInt = &ciVar;
+    
+
+    ///* Arrays of strings ..........................................................:
+    /* Note:
+        There is a disadvantage to using an array of strings, 
+        in that the subarrays that hold the strings must all be the same length. */
+    // But we can use pointers to solve this problem:
+    
+    const int DAYS = 7;
+    char* pDays[DAYS] = {"Saturday", "Sunday", "Monday", "Tuesday",
+                        "Wedensday", "Thursday", "Friday"};
+    for (i = 0; i < DAYS; i++)
+    {   cout << endl << pDays[i]; } cout << endl;
+    
+    // • The char pointer holds the address of the head character in the string. 
+    //      It is these addresses that are stored in the array. 
+    //      (while actual strings' values are not part of the array.)
+   
+    // • When strings are not part of an array, C++ places them 'contiguously' in memory,
+    //      So there is no wasted space.
+    
+    
+    ///* Memory Management: 'new' and 'delete' ......................................:
+    
+    // The 'new' operator: obtains memory from the operating system
+    //   and returns a pointer to its starting point (with the appropraite data type.) 
+    char str5[] = "Idle hands are the devil's workshop.";
+    int len = strlen(str5);
+    
+    char *pch;
+    pch = new char[len + 1];        // sets aside memory: string + '\0' (dynamically allocated memory)
+
+    strcpy(pch, str5);
+    cout << "\npch = " << pch << endl;
+    
+    /* There is no C++ equivalent to 'realloc' where you can change the size of memory that has been alloctaed.
+        - You'll need to fall back on the ploy of creating a larger (or smaller) space with new, 
+            and copying your data from the old area to the new one.  
+    */
+    
+    delete[] pch;                   // release pointer's memory
+
+    /* Using new and delete in functions
+        - If the function uses a local variable as a pointer to this memory, 
+            the pointer will be destroyed when the function terminates.
+        BUT: the memory will be left as an orphan, taking up space that is inaccessible to the rest of the program. 
+            So, Thus it is always good practice, and often essential, to delete memory when you're through with it.
+    */
+    // Note: Deleting the memory doesn't delete the pointer that points to it.
+    //       and doesn't change the address value in the pointer. 
+    //       However, this address is no longer valid (doesn't point to allocated memory.)
+
+    char* chPtrsArray[MAX];         // Array of pointers to chars
+    for (i = 0; i < MAX; i++)       // allocated memory for char for every pointer
+    {   chPtrsArray[i] = new char; }
+    
+    // To delete the allocated memory for every pointer:
+    for (i = 0; i < MAX; i++)
+    {   delete chPtrsArray[i]; }
+    // Note:
+    // delete[] chPtrsArray;        // will delete the array of pointers, NOT the allocated memory that every pointers point to.
+    
+    
+    // allocating a single object
+    float * pFloat = new float;     // note that this var has name, only a pointer to it.
+    delete pFloat;
+
+    
+    ///* String class using 'new' ...................................................:
+    String s1  = "Who knows nothing, doubts every thing.";
+    cout << "\ns1 = "; s1.display();
+
+    String s2 = s1;     // the copy constructor gives s2 its own copy of the characters.
+    cout << "s2 = "; s2.display();
+    cout << endl;
+
+
+    ///* Creating objects at run-time ...............................................:
+    Distance dist1;             // normal nammed object
+    dist1.get_dist();
+    dist1.show_dist();
+    cout << endl;
+
+    Distance *pDist;            // pointer to Distance
+    pDist = new Distance;       // allocate memory for a Distance at run-time
+    pDist->get_dist();          // access the unnamed object members
+    pDist->show_dist();         // using the membership-access operator -> 
+    (*pDist).show_dist();       // this is ok as well but not elegant!
+    cout << endl;
+
+    // OR (for a less common approach):
+    // You can refer to objects obtained with 'new' by an alias:
+    Distance& dist2 = *(new Distance);
+    dist2.get_dist();           // use the dot operator . normally
+    dist2.show_dist();
+    cout << endl;
+
+
+    ///* Array of pointers to objects ...............................................:
+    Person* pPer[100];
+    int n = 0;
+    char choice;
+
+    do
+    {
+        pPer[n] = new Person;
+        pPer[n]->setName();
+        n++;
+        cout << "Enter another (y/n)? "; cin >> choice;        
+    } while (choice == 'y');
+    
+
+    for (i = 0; i < n; i++)
+    {   pPer[i]->printName(); }
+    cout << endl;
+
+
+    ///* Pointers to pointers .......................................................:
+    void Person_bsort(Person**, int);
+    Person_bsort(pPer, n);
+
+    cout << "\nList sorted: \n";
+    for (i = 0; i < n; i++)
+    {   pPer[i]->printName(); }     cout << endl;
+    
+    /* Sorting pointers:
+        • when we sort person objects for example, we don't move the objects themselves; 
+            we move the pointers to the objects. 
+            ► This eliminates the need to shuffle the objects around in memory,
+                which can be very time-consuming if the objects are large.
+            ► It could also, if we wanted, allow us to keep multiple sorts —one by name and another by phone number, for example—
+                in memory at the same time without storing the objects multiple times.
+                (and that can be done by creating another array of pointers which we can sort in another way.)
+    */
+   
+
+    ///* Linked lists ...............................................................:
+    Linklist lInt;        // make an int linked list
+    lInt.add_item(25);
+    lInt.add_item(56);
+    lInt.add_item(89);
+    lInt.add_item(46);
+
+    lInt.display();
+
+
+    ///* Example: Parsing Arithmetic Operations: .............................................:
+    char ans;
+    char str[LEN];
+
+    cout << "\nEnter an arithmetic expression of the form 2+3*4/3-2"
+            "\nNo number may have more than one digit."
+            "\nDont use any spaces or parantheses.";
+    do
+    {
+        cout << "\nEnter expression:" << endl;
+        cin >> str;
+        Expr* pExpr = new Expr(str);     // make expression
+        cout << "= " << pExpr->evaluate();
+        delete pExpr;
+
+        cout << "\nDo another? (y/n): ";    cin >> ans;
+    } while (ans =='y');
+    
+
+
+    
+    return 0;
+}
+#endif
+
+
+
+///* functions definitions ..........................................................:
+
+void centimize(double* pDist)
+{   *pDist *= 2.54; }
+
+
+void centimizeArr(double* pArr)
+{   
+    for (int i = 0; i < MAX; i++)
+    {   *pArr++ *= 2.54; }    
+}
+
+
+// Bubble Sort ....................................................:
+// These keep their (int*, int) shape for their callers, but do the work with intro_sort() (see Sorting Library.)
+void BubbleSort(int *arr, int n)
+{   intro_sort(arr, n); }
+
+void BubbleSort2(int *arr, int n)
+{   intro_sort(arr, n); }
+
+void BubbleSort3(int *arr, int size)
+{   intro_sort(arr, size); }
+
+/* Note:
+    The book's bubble sorts are kept below for reference.
+    Beside being O(n²), they swap with the XOR trick: X ^= Y ^= X ^= Y
+        ► If X and Y are the same variable (the same array element), the first X ^= X makes it 0, and the value is lost.
+        ► The expression also modifies X twice without a sequence point, which is undefined behavior before C++17.
+    A temporary variable (or std::swap) doesn't have these problems, and is just as fast.
+*/
+#if 0
+#define SWAP(X, Y)      (X^=Y^=X^=Y)
+#define ORDER(X, Y)     ((X > Y) ? SWAP(X, Y) : 1)
+
+// Bubble sort variation: specifying minimums to the beginning of the list
+void BubbleSort(int *arr, int n)
+{
+    int i, j;
+    for (i = 0; i < n - 1; i++)
+        for (j = i + 1; j < n; j++)
+            ORDER(arr[i], arr[j]);
+}
+
+
+// Bubble sort variation: specifying maximums to the end of the list
+void BubbleSort2(int *arr, int n)
+{
+    int i, j, swpd = 0;
+    for (i = 0; i < n - 1; i++)
+    {
+        for (j = 0; j < n - i - 1; j++)
+            {   ORDER(arr[j], arr[j + 1]);  swpd = 1; }
+        if(!swpd) break;
+    }   
+}
+
+
+void BubbleSort3(int *arr, int size)
+{
+    int swapped = 0;
+    for (int i = 0; i < size - 1; i++)
+    {
+        for (int j = 0; j < size - i - 1; j++)
+        {
+            if(arr[j] > arr[j + 1])
+            {   
+                arr[j] ^= arr[j+1] ^= arr[j] ^= arr[j+1];   // swap
+                swapped = 1;
+            } 
+        }
+        if(swapped == 0) {cout << "\nswapped"; break;}   
+    }
+}
+#endif
+
+
+// String functions ................................................:
+// They used to walk the string one char at a time (kept below);
+// now they find its end 16/32 chars at a time (see simd_cstring.h) and move it as a whole.
+void dispStr(char* str)
+{
+    cout.write(str, fast_strlen(str));
+    cout << endl;
+}
+
+void cpyStr(char* dst, const char* src)
+{   fast_strcpy(dst, src); }
+
+#if 0
+void dispStr(char* str)
+{
+    while(*str) 
+        cout << *str++;
+    cout << endl;
+}
+
+void cpyStr(char* dst, const char* src)
+{
+    while(*src)
+        *dst++ = *src++;
+    *dst = 0;
+}
+#endif
+
+
+// Person Bubble Sort..............................................:
+void Person_bsort(Person** pp, int n)
+{
+    void order(Person**, Person**);         // We will change the ptr to Person. So, we need to pass a ptr to it (ptr to ptr)
+    int i, j;
+    for (i = 0; i < n - 1; i++)
+        for (j = i + 1; j < n; j++)
+            {   order(&pp[i], &pp[j]); }
+        // or:  order(pp + i, pp + j); 
+}
+
+void order(Person** pp1, Person** pp2)
+{
+    if((*pp1)->getName() > (*pp2)->getName())
+    {
+        Person* temp = *pp1;
+        *pp1 = *pp2;
+        *pp2 = temp;
+    }
+}       
+
+
+// Person Key Sort ................................................:
+/*
+    Person_bsort() compares names O(n²) times, and it reaches every name through a pointer to a Person somewhere in memory.
+    ► Person_keysort() reads every name only once, to make a small 'key' for every person:
+        • 'prefix': the first 8 characters of the name packed into one 64-bit integer (first character in the highest byte),
+            so comparing two prefixes is a single integer comparison that gives the same order as comparing the strings,
+        • 'name': a pointer to the full name, only looked at when two prefixes are equal (no string is copied),
+        • 'index': where the person was in the array (so equal names keep their order.)
+    The keys are stored next to each other and sorted with intro_sort(); then the pointers are put in the keys' order.
+*/
+struct PersonKey
+{
+    unsigned long long prefix;
+    const string* name;
+    int index;
+
+    bool operator < (const PersonKey& k) const
+    {
+        if(prefix != k.prefix)
+            return prefix < k.prefix;
+        int c = name->compare(*k.name);
+        return (c != 0) ? c < 0 : index < k.index;
+    }
+};
+
+void Person_keysort(Person** pp, int n)
+{
+    vector<PersonKey> keys(n);
+    for(int i = 0; i < n; i++)
+    {
+        const string& name = pp[i]->getName();
+        unsigned long long prefix = 0;
+        for(int c = 0; c < 8; c++)      // (shorter names are padded with zeros, which sort first like the end of a string)
+            prefix = (prefix << 8) | (c < int(name.size()) ? (unsigned char)name[c] : 0);
+        keys[i].prefix = prefix;
+        keys[i].name = &name;
+        keys[i].index = i;
+    }
+
+    intro_sort(keys.data(), n);
+
+    vector<Person*> sorted(n);
+    for(int i = 0; i < n; i++)
+        sorted[i] = pp[keys[i].index];
+    copy(sorted.begin(), sorted.end(), pp);
+}
+
+
+
+
+///* Benchmark: Expr::evaluate() vs. ExprProgram::run() ..............................:
+// Expr only knows digits, so it gets the formulas with the variables' values written in (a = 1, b = 2, ... i = 9),
+// while the program keeps the variables (a formula of constants would be folded into a single CONST).
+#if 0
+int main()
+{
+    char formulas[][LEN] = { "2+3*4", "9-8+7-6+5", "8/2*3+1-4/2", "1+2+3+4+5+6+7+8+9" };
+    const char* withVars[] = { "b+c*d", "i-h+g-f+e", "h/b*c+a-d/b", "a+b+c+d+e+f+g+h+i" };
+    const int vars[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    const int* volatile pVars = vars;
+    const int N = 2000000;
+    // 'volatile' pointers stop the compiler from hoisting the (same) evaluation out of the loops
+    char* volatile pStr;
+    ExprProgram* volatile pProg;
+
+    for(int f = 0; f < 4; f++)
+    {
+        long sum1 = 0, sum2 = 0;
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        pStr = formulas[f];
+        for(int i = 0; i < N; i++)
+        {
+            Expr expr(pStr);                    // re-parses the text on every evaluation
+            sum1 += expr.evaluate();
+        }
+        double tExpr = seconds_since(start);
+
+        start = chrono::steady_clock::now();
+        ExprProgram prog;
+        prog.compile(withVars[f]);              // parsed only once
+        pProg = &prog;
+        for(int i = 0; i < N; i++)
+        {   sum2 += pProg->run(pVars); }
+        double tProg = seconds_since(start);
+
+        cout << formulas[f] << "  as  " << withVars[f] << "\t(" << prog.size() << " instructions)"
+             << "\n\tevaluate(): " << N / tExpr / 1e6 << " M evals/s"
+             << "\n\trun():      " << N / tProg / 1e6 << " M evals/s"
+             << "\t(speedup " << tExpr / tProg << "x)"
+             << ((sum1 == sum2) ? "" : "\tRESULTS DIFFER") << endl;
+    }
+    return 0;
+}
+#endif
+
+
+
+///* Benchmark: ExprProgram::run() per row vs. run_batch() over columns .................:
+#if 0
+template <class T>
+void bench_batch(const char* formula, const char* typeName, int nRows)
+{
+    ExprProgram prog;
+    if(!prog.compile(formula))
+    {   cout << "Bad formula: " << formula << endl; return; }
+
+    int nVars = prog.vars_used();
+    vector< vector<T> > cols(nVars, vector<T>(nRows));
+    vector<const T*> pCols(nVars);
+    for(int v = 0; v < nVars; v++)
+    {
+        for(int i = 0; i < nRows; i++)
+            cols[v][i] = T(1 + (i * 7 + v * 13) % 97);     // never zero (for integer division)
+        pCols[v] = cols[v].data();
+    }
+    vector<T> out1(nRows), out2(nRows);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    T row[26];
+    for(int i = 0; i < nRows; i++)                          // scalar loop: one run() per row
+    {
+        for(int v = 0; v < nVars; v++)
+            row[v] = cols[v][i];
+        out1[i] = prog.run(row);
+    }
+    double tScalar = seconds_since(start);
+
+    start = chrono::steady_clock::now();
+    prog.run_batch(pCols.data(), nRows, out2.data());
+    double tBatch = seconds_since(start);
+
+    cout << formula << " (" << typeName << ")"
+         << "\n\tscalar: " << nRows / tScalar / 1e6 << " M rows/s"
+         << "\n\tbatch:  " << nRows / tBatch / 1e6 << " M rows/s"
+         << "\t(speedup " << tScalar / tBatch << "x)"
+         << ((out1 == out2) ? "" : "\tRESULTS DIFFER") << endl;
+}
+
+int main()
+{
+    const int ROWS = 10000000;
+    bench_batch<int>("a+b*c-d", "int", ROWS);
+    bench_batch<int>("a*b+c*d-e/2", "int", ROWS);
+    bench_batch<double>("a+b*c-d", "double", ROWS);
+    bench_batch<double>("a*b+c*d-e/2", "double", ROWS);
+    return 0;
+}
+#endif
+
+
+///* Evaluating an Expression File in Parallel .........................................:
+/*
+    Usage:  10_pointers input.txt [output.txt] [threads]    evaluates one expression per line
+            10_pointers --bench [lines] [N]                 lines/s for 1..N threads (N = number of cores)
+
+    • The input file is memory-mapped: the operating system maps the file into our address space,
+        so it can be read like one big char array without copying it into buffers first.
+    • The file is cut into chunks of about CHUNK bytes, each ending at a '\n', 
+        so no line is ever split between two chunks.
+    • Each worker thread starts with its own contiguous share of the chunks (in a double-ended queue).
+        It takes chunks from the front of its own queue, and when it runs out 
+        it 'steals' chunks from the back of another worker's queue.
+        → Workers that get easy chunks don't sit idle while another worker still has a long queue.
+    • Every chunk writes its results into its own string, and the strings are written out in chunk order,
+        so the results come out in input order no matter which thread evaluated which chunk.
+*/
+#if 0
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <functional>
+#include <cstdio>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+class MappedFile                        // a read-only view of a whole file
+{
+private:
+    const char* pData;
+    size_t len;
+#ifdef _WIN32
+    HANDLE hFile, hMap;
+#endif
+    MappedFile(const MappedFile&);
+    MappedFile& operator = (const MappedFile&);
+public:
+    MappedFile(const char* name);
+    ~MappedFile();
+    bool is_open() const
+    {   return pData != NULL || len == 0; }
+    const char* data() const
+    {   return pData; }
+    size_t size() const
+    {   return len; }
+};
+
+#ifdef _WIN32
+MappedFile::MappedFile(const char* name) : pData(NULL), len(0), hMap(NULL)
+{
+    hFile = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    LARGE_INTEGER size;
+    if(hFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(hFile, &size))
+    {   len = 1; return; }              // (is_open() reports the failure)
+    len = size_t(size.QuadPart);
+    if(len == 0)
+        return;
+    hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(hMap != NULL)
+        pData = (const char*)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+}
+
+MappedFile::~MappedFile()
+{
+    if(pData) UnmapViewOfFile(pData);
+    if(hMap) CloseHandle(hMap);
+    if(hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+}
+#else
+MappedFile::MappedFile(const char* name) : pData(NULL), len(0)
+{
+    int fd = open(name, O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) < 0)
+    {   len = 1; if(fd >= 0) close(fd); return; }
+    len = size_t(st.st_size);
+    if(len > 0)
+    {
+        void* p = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p != MAP_FAILED)
+        {
+            pData = (const char*)p;
+            madvise(p, len, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);                          // the mapping stays valid after closing the file
+}
+
+MappedFile::~MappedFile()
+{
+    if(pData) munmap((void*)pData, len);
+}
+#endif
+
+
+class WorkStealingPool
+{
+private:
+    struct Queue
+    {
+        mutex lock;
+        deque<int> tasks;
+    };
+    int nThreads;
+    vector<Queue> queues;               // one queue of task numbers per worker
+    bool take(int worker, int& task);
+    void work(int worker, const function<void(int)>& job);
+public:
+    WorkStealingPool(int n) : nThreads(n), queues(n)
+    {   }
+    void run(int nTasks, const function<void(int)>& job);   // job(0) ... job(nTasks-1), returns when all are done
+};
+
+bool WorkStealingPool::take(int worker, int& task)
+{
+    {
+        Queue& own = queues[worker];
+        lock_guard<mutex> guard(own.lock);
+        if(!own.tasks.empty())
+        {
+            task = own.tasks.front();   // own work: from the front
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    for(int i = 1; i < nThreads; i++)
+    {
+        Queue& victim = queues[(worker + i) % nThreads];
+        lock_guard<mutex> guard(victim.lock);
+        if(!victim.tasks.empty())
+        {
+            task = victim.tasks.back(); // stolen work: from the back (the victim's latest tasks)
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;                       // all tasks are given out (no new tasks are ever added)
+}
+
+void WorkStealingPool::work(int worker, const function<void(int)>& job)
+{
+    int task;
+    while(take(worker, task))
+        job(task);
+}
+
+void WorkStealingPool::run(int nTasks, const function<void(int)>& job)
+{
+    for(int w = 0; w < nThreads; w++)   // worker w starts with a contiguous share of the tasks
+        for(int t = int(long(nTasks) * w / nThreads); t < int(long(nTasks) * (w + 1) / nThreads); t++)
+            queues[w].tasks.push_back(t);
+
+    vector<thread> workers;
+    for(int w = 1; w < nThreads; w++)
+        workers.push_back(thread(&WorkStealingPool::work, this, w, cref(job)));
+    work(0, job);                       // the calling thread is worker 0
+    for(size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+
+// evaluates every line in [first, last), appending one result line per input line to 'out'
+void evaluate_lines(const char* first, const char* last, string& out)
+{
+    ExprProgram prog;                   // reused for every line: its code vector keeps its memory
+    char buf[32];
+
+    while(first < last)
+    {
+        const char* eol = (const char*)memchr(first, '\n', last - first);
+        if(eol == NULL)
+            eol = last;
+        const char* end = (eol > first && eol[-1] == '\r') ? eol - 1 : eol;
+
+        if(end == first)
+            ;                           // an empty line gives an empty result line
+        else if(!prog.compile(first, end))
+        {   out += "error: "; out += prog.error(); }
+        else if(prog.vars_used() > 0)
+            out += "error: variables have no values";
+        else
+        {
+            const char* err;            // a division by 0 is an error for this line only
+            int value = prog.run(&err);
+            if(err)
+            {   out += "error: "; out += err; }
+            else
+            {
+                snprintf(buf, sizeof(buf), "%d", value);
+                out += buf;
+            }
+        }
+        out += '\n';
+        first = eol + 1;
+    }
+}
+
+// evaluates a whole buffer of lines with nThreads workers; results[i] holds the results of chunk i
+void evaluate_buffer(const char* data, size_t size, int nThreads, vector<string>& results)
+{
+    const size_t CHUNK = 256 * 1024;
+    vector<const char*> bounds(1, data);        // chunk i is [bounds[i], bounds[i+1])
+    const char* end = data + size;
+    while(bounds.back() < end)
+    {
+        const char* cut = bounds.back() + CHUNK;
+        if(cut >= end)
+            cut = end;
+        else
+        {
+            const char* eol = (const char*)memchr(cut, '\n', end - cut);
+            cut = (eol == NULL) ? end : eol + 1;
+        }
+        bounds.push_back(cut);
+    }
+
+    int nChunks = bounds.size() - 1;
+    results.assign(nChunks, string());
+    WorkStealingPool pool(nThreads);
+    pool.run(nChunks, [&](int i)
+    {
+        results[i].reserve(bounds[i + 1] - bounds[i]);
+        evaluate_lines(bounds[i], bounds[i + 1], results[i]);
+    });
+}
+
+
+int main(int argc, char* argv[])
+{
+    int nCores = thread::hardware_concurrency();
+    if(nCores < 1)
+        nCores = 1;
+
+    if(argc >= 2 && strcmp(argv[1], "--bench") == 0)
+    {
+        long nLines = (argc >= 3) ? atol(argv[2]) : 2000000;
+        if(argc >= 4)
+            nCores = atoi(argv[3]);
+        string text;
+        char line[64];
+        for(long i = 0; i < nLines; i++)
+        {
+            snprintf(line, sizeof(line), "%ld*(%ld+7)-%ld/3+(-%ld)\n", i % 1000, i % 97, i % 5000 + 1, i % 13);
+            text += line;
+        }
+
+        vector<string> results;
+        double t1 = 0;
+        for(int n = 1; n <= nCores; n *= 2)
+        {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            evaluate_buffer(text.data(), text.size(), n, results);
+            double t = seconds_since(start);
+            if(n == 1)
+                t1 = t;
+            cout << n << " thread(s): " << nLines / t / 1e6 << " M lines/s"
+                 << "\t(speedup " << t1 / t << "x)" << endl;
+            if(n < nCores && n * 2 > nCores)
+                n = nCores / 2;         // make sure the last run uses all the cores
+        }
+        return 0;
+    }
+
+    if(argc < 2)
+    {   cout << "Usage: " << argv[0] << " input.txt [output.txt] [threads]" << endl; return 1; }
+
+    MappedFile in(argv[1]);
+    if(!in.is_open())
+    {   cerr << "Can't open " << argv[1] << endl; return 1; }
+
+    FILE* out = stdout;
+    if(argc >= 3 && (out = fopen(argv[2], "wb")) == NULL)
+    {   cerr << "Can't create " << argv[2] << endl; return 1; }
+    int nThreads = (argc >= 4) ? atoi(argv[3]) : nCores;
+    if(nThreads < 1)
+        nThreads = 1;
+
+    vector<string> results;
+    evaluate_buffer(in.data(), in.size(), nThreads, results);
+    for(size_t i = 0; i < results.size(); i++)      // in input order
+        fwrite(results[i].data(), 1, results[i].size(), out);
+
+    if(out != stdout)
+        fclose(out);
+    return 0;
+}
+#endif
+
+
+
+///* Benchmark: ExprCache under a stream of repeated formulas ...........................:
+#if 0
+int main()
+{
+    const int DISTINCT = 5000;          // different formulas in the stream
+    const int LINES = 2000000;
+    vector<string> formulas;
+    char buf[64];
+    for(int i = 0; i < DISTINCT; i++)
+    {
+        snprintf(buf, sizeof(buf), "(%d*(%d+%d)-%d)/(%d+%d)+(%d*(%d+%d)-%d)", i % 91, i % 37, i % 11, i, i % 7 + 1, i % 5,
+                                                                        i % 91, i % 37, i % 11, i);
+        formulas.push_back(buf);
+    }
+    vector<int> stream(LINES);          // skewed: a few formulas are much more frequent than the others
+    for(int i = 0; i < LINES; i++)
+    {
+        unsigned r = unsigned(i) * 2654435761u;
+        stream[i] = int((unsigned long long)(r % DISTINCT) * (r % DISTINCT) / DISTINCT);
+    }
+
+    long sum1 = 0, sum2 = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    ExprProgram prog;
+    for(int i = 0; i < LINES; i++)      // compile and run every line
+    {
+        prog.compile(formulas[stream[i]].c_str());
+        sum1 += prog.run();
+    }
+    double tPlain = seconds_since(start);
+
+    for(int cap = 256; cap <= 8192; cap *= 4)
+    {
+        ExprCache cache(cap);
+        sum2 = 0;
+        start = chrono::steady_clock::now();
+        for(int i = 0; i < LINES; i++)
+        {
+            const string& f = formulas[stream[i]];
+            int result;
+            const char* err;
+            if(cache.evaluate(f.data(), f.data() + f.size(), result, err))
+                sum2 += result;
+        }
+        double tCache = seconds_since(start);
+        cout << "capacity " << cap << ":\thits " << cache.hits() << "\tmisses " << cache.misses()
+             << "\tevictions " << cache.evictions()
+             << "\n\t" << LINES / tCache / 1e6 << " M lines/s with the cache, "
+             << LINES / tPlain / 1e6 << " M lines/s without"
+             << ((sum1 == sum2) ? "" : "\tRESULTS DIFFER") << endl;
+    }
 
-    
-    ///* String class using 'new' ...................................................:
-    String s1  = "Who knows nothing, doubts every thing.";
-    cout << "\ns1 = "; s1.display();
+    ExprProgram shared;                 // the optimizer at work
+    shared.compile("(a*b+c)/(a*b+c)+(2+3)*a");
+    cout << "(a*b+c)/(a*b+c)+(2+3)*a compiles to " << shared.size() << " instructions" << endl;
+    return 0;
+}
+#endif
 
-    String s2 = s1;     // only copies the char* ptr to the same allocated memory.
-    cout << "s2 = "; s2.display();
-    cout << endl;
 
 
-    ///* Creating objects at run-time ...............................................:
-    Distance dist1;             // normal nammed object
-    dist1.get_dist();
-    dist1.show_dist();
-    cout << endl;
+///* Benchmark: Linklist::add_item() with a slab vs. 'new' for every link ...............:
+#if 0
+class NewLinklist                   // the list before the slab: one 'new' (and one 'delete') per link
+{
+private:
+    Link* head;
+public:
+    NewLinklist() : head(NULL)
+    {   }
+    ~NewLinklist()
+    {
+        while(head != NULL)
+        {
+            Link* next = head->next;
+            delete head;
+            head = next;
+        }
+    }
+    void add_item(int d)
+    {
+        Link* newlink = new Link;
+        newlink->data = d;
+        newlink->next = head;
+        head = newlink;
+    }
+};
 
-    Distance *pDist;            // pointer to Distance
-    pDist = new Distance;       // allocate memory for a Distance at run-time
-    pDist->get_dist();          // access the unnamed object members
-    pDist->show_dist();         // using the membership-access operator -> 
-    (*pDist).show_dist();       // this is ok as well but not elegant!
-    cout << endl;
+int main()
+{
+    for(int n = 1000000; n <= 16000000; n *= 4)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        NewLinklist* pNew = new NewLinklist;
+        for(int i = 0; i < n; i++)
+            pNew->add_item(i);
+        double tNewAdd = seconds_since(start);
+        start = chrono::steady_clock::now();
+        delete pNew;
+        double tNewFree = seconds_since(start);
+
+        start = chrono::steady_clock::now();
+        Linklist* pSlab = new Linklist;
+        for(int i = 0; i < n; i++)
+            pSlab->add_item(i);
+        double tSlabAdd = seconds_since(start);
+        start = chrono::steady_clock::now();
+        delete pSlab;
+        double tSlabFree = seconds_since(start);
+
+        cout << n << " links:"
+             << "\n\tnew:  add " << n / tNewAdd / 1e6 << " M/s, free " << tNewFree * 1e3 << " ms"
+             << "\n\tslab: add " << n / tSlabAdd / 1e6 << " M/s, free " << tSlabFree * 1e3 << " ms"
+             << "\t(add speedup " << tNewAdd / tSlabAdd << "x)" << endl;
+    }
+    return 0;
+}
+#endif
 
-    // OR (for a less common approach):
-    // You can refer to objects obtained with 'new' by an alias:
-    Distance& dist2 = *(new Distance);
-    dist2.get_dist();           // use the dot operator . normally
-    dist2.show_dist();
-    cout << endl;
 
 
-    ///* Array of pointers to objects ...............................................:
-    Person* pPer[100];
-    int n = 0;
-    char choice;
+///* Benchmark: traversing Linklist vs. UnrolledList vs. an array ......................:
+#if 0
+int main()
+{
+    const long MAX_N = 100000000;       // 10^8 items: about 2.5 GB for the three containers together
+    const long WORK = 200000000;        // items summed per container (small lists are traversed many times)
 
-    do
+    for(long n = 1000; n <= MAX_N; n *= 10)
     {
-        pPer[n] = new Person;
-        pPer[n]->setName();
-        n++;
-        cout << "Enter another (y/n)? "; cin >> choice;        
-    } while (choice == 'y');
-    
+        Linklist* pList = new Linklist;
+        UnrolledList* pUnrolled = new UnrolledList;
+        vector<int> arr(n);
+        for(long i = 0; i < n; i++)
+        {
+            pList->add_item(int(i));
+            pUnrolled->add_item(int(i));
+            arr[i] = int(i);
+        }
+        long reps = (WORK / n > 0) ? WORK / n : 1;
+        long long s1 = 0, s2 = 0, s3 = 0;
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for(long r = 0; r < reps; r++)
+            s1 += pList->sum();
+        double tList = seconds_since(start) / (reps * n) * 1e9;
+
+        start = chrono::steady_clock::now();
+        for(long r = 0; r < reps; r++)
+            s2 += pUnrolled->sum();
+        double tUnrolled = seconds_since(start) / (reps * n) * 1e9;
+
+        start = chrono::steady_clock::now();
+        for(long r = 0; r < reps; r++)
+            for(long i = 0; i < n; i++)
+                s3 += arr[i];
+        double tArray = seconds_since(start) / (reps * n) * 1e9;
+
+        cout << n << " items (ns per item):\tLinklist " << tList << "\tUnrolledList " << tUnrolled
+             << "\tarray " << tArray << ((s1 == s2 && s2 == s3) ? "" : "\tSUMS DIFFER") << endl;
+
+        delete pList;
+        delete pUnrolled;
+    }
+    return 0;
+}
+#endif
 
-    for (i = 0; i < n; i++)
-    {   pPer[i]->printName(); }
-    cout << endl;
 
+///* Benchmark: ConcurrentLinklist stress test, then pushes/s from 1 to N threads .......:
+#if 0
+// Stress test: producers push, readers check their snapshots, and one thread keeps clearing the list.
+bool stress_test(int nProducers, int nReaders, int perProducer)
+{
+    ConcurrentLinklist list;
+    atomic<bool> done(false);
+    atomic<long> badSnapshots(0);
+    atomic<long long> clearedSum(0);
+    atomic<long> clearedCount(0);
+
+    vector<thread> threads;
+    for(int p = 0; p < nProducers; p++)
+        threads.push_back(thread([&, p]()
+        {
+            for(int i = 0; i < perProducer; i++)
+                list.add_item(p * perProducer + i + 1);
+        }));
+    for(int r = 0; r < nReaders; r++)
+        threads.push_back(thread([&]()
+        {
+            while(!done.load())
+            {
+                long n;
+                long long s = list.sum(&n);
+                if(n < 0 || s < n)              // every item is >= 1, so the sum can't be below the count
+                    badSnapshots++;
+            }
+        }));
+    thread clearer([&]()
+    {
+        while(!done.load())
+        {
+            long n;
+            clearedSum += list.clear(&n);
+            clearedCount += n;
+            this_thread::yield();
+        }
+    });
+
+    for(int p = 0; p < nProducers; p++)
+        threads[p].join();
+    done.store(true);
+    for(size_t i = nProducers; i < threads.size(); i++)
+        threads[i].join();
+    clearer.join();
+
+    long n;
+    long long s = list.sum(&n);
+    long long all = (long long)nProducers * perProducer;
+    bool ok = badSnapshots == 0 && clearedCount + n == all && clearedSum + s == all * (all + 1) / 2;
+    cout << "stress test (" << nProducers << " producers, " << nReaders << " readers): "
+         << (ok ? "passed" : "FAILED") << endl;
+    return ok;
+}
 
-    ///* Pointers to pointers .......................................................:
-    void Person_bsort(Person**, int);
-    Person_bsort(pPer, n);
 
-    cout << "\nList sorted: \n";
-    for (i = 0; i < n; i++)
-    {   pPer[i]->printName(); }     cout << endl;
-    
-    /* Sorting pointers:
-        • when we sort person objects for example, we don't move the objects themselves; 
-            we move the pointers to the objects. 
-            ► This eliminates the need to shuffle the objects around in memory,
-                which can be very time-consuming if the objects are large.
-            ► It could also, if we wanted, allow us to keep multiple sorts —one by name and another by phone number, for example—
-                in memory at the same time without storing the objects multiple times.
-                (and that can be done by creating another array of pointers which we can sort in another way.)
-    */
-   
+int main()
+{
+    int nCores = thread::hardware_concurrency();
+    if(nCores < 2)
+        nCores = 2;
 
-    ///* Linked lists ...............................................................:
-    Linklist lInt;        // make an int linked list
-    lInt.add_item(25);
-    lInt.add_item(56);
-    lInt.add_item(89);
-    lInt.add_item(46);
+    if(!stress_test(nCores, 2, 200000))
+        return 1;
 
-    lInt.display();
+    const int PUSHES = 8000000;                 // in total, shared by the producers
+    for(int nProducers = 1; nProducers <= nCores; nProducers *= 2)
+    {
+        ConcurrentLinklist list;
+        vector<thread> threads;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for(int p = 0; p < nProducers; p++)
+            threads.push_back(thread([&]()
+            {
+                for(int i = 0; i < PUSHES / nProducers; i++)
+                    list.add_item(i);
+            }));
+        for(int p = 0; p < nProducers; p++)
+            threads[p].join();
+        double t = seconds_since(start);
+        cout << nProducers << " producer(s): " << PUSHES / t / 1e6 << " M pushes/s" << endl;
+    }
+    return 0;
+}
+#endif
 
 
-    ///* Example: Parsing Arithmetic Operations: .............................................:
-    char ans;
-    char str[LEN];
 
-    cout << "\nEnter an arithmetic expression of the form 2+3*4/3-2"
-            "\nNo number may have more than one digit."
-            "\nDont use any spaces or parantheses.";
-    do
+///* Benchmark: intro_sort() vs. std::sort() (and the old bubble sort) .................:
+#if 0
+void old_bubble_sort(int *arr, int size)    // BubbleSort3 as it was (with a correct swap)
+{
+    for (int i = 0; i < size - 1; i++)
     {
-        cout << "\nEnter expression:" << endl;
-        cin >> str;
-        Expr* pExpr = new Expr(str);     // make expression
-        cout << "= " << pExpr->evaluate();
-        delete pExpr;
+        int swapped = 0;
+        for (int j = 0; j < size - i - 1; j++)
+            if(arr[j] > arr[j + 1])
+            {   int t = arr[j]; arr[j] = arr[j + 1]; arr[j + 1] = t; swapped = 1; }
+        if(!swapped) break;
+    }
+}
 
-        cout << "\nDo another? (y/n): ";    cin >> ans;
-    } while (ans =='y');
-    
+// fills arr with one of the input patterns
+void fill_pattern(vector<int>& arr, int pattern)
+{
+    unsigned r = 12345;
+    for(size_t i = 0; i < arr.size(); i++)
+    {
+        r = r * 1103515245u + 12345u;
+        switch(pattern)
+        {
+        case 0: arr[i] = int(i); break;                         // sorted
+        case 1: arr[i] = int(arr.size() - i); break;            // reverse
+        case 2: arr[i] = int(r >> 1); break;                    // random
+        case 3: arr[i] = int((r >> 16) % 10); break;            // few unique
+        }
+    }
+}
 
+int main()
+{
+    const char* names[] = { "sorted", "reverse", "random", "few unique" };
+    const int N = 5000000;
+    const int N_BUBBLE = 20000;
 
-    
+    for(int pattern = 0; pattern < 4; pattern++)
+    {
+        vector<int> a(N), b;
+        fill_pattern(a, pattern);
+        b = a;
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        BubbleSort(a.data(), N);                                // (now intro_sort)
+        double tIntro = seconds_since(start);
+
+        start = chrono::steady_clock::now();
+        sort(b.begin(), b.end());
+        double tStd = seconds_since(start);
+
+        vector<int> c(N_BUBBLE);
+        fill_pattern(c, pattern);
+        start = chrono::steady_clock::now();
+        old_bubble_sort(c.data(), N_BUBBLE);
+        double tBubble = seconds_since(start);
+
+        cout << names[pattern] << ":\tintro_sort " << tIntro * 1e3 << " ms, std::sort " << tStd * 1e3 << " ms"
+             << " (" << N << " ints)" << (a == b ? "" : "\tNOT SORTED")
+             << "\n\t\told bubble sort " << tBubble * 1e3 << " ms (only " << N_BUBBLE << " ints)" << endl;
+    }
     return 0;
 }
+#endif
 
 
 
-///* functions definitions ..........................................................:
-
-void centimize(double* pDist)
-{   *pDist *= 2.54; }
-
+///* Benchmark: radix sort vs. the comparison sorts, from 16 to 10^8 ints ...............:
+#if 0
+int main()
+{
+    const long MAX_N = 100000000;
+    const long WORK = 20000000;         // ints sorted per size (small arrays are sorted many times)
+    RadixSorter radix(0);               // no cutoff: always radix sort (to find the crossover)
+    unsigned r = 1;
 
-void centimizeArr(double* pArr)
-{   
-    for (int i = 0; i < MAX; i++)
-    {   *pArr++ *= 2.54; }    
+    cout << "ints\tns per int:  radix\tintro_sort\tstd::sort" << endl;
+    for(long n = 16; n <= MAX_N; n *= 4)
+    {
+        vector<int> input(n), a(n), b(n), c(n);
+        for(long i = 0; i < n; i++)
+        {   r = r * 1103515245u + 12345u; input[i] = int(r ^ (r >> 15)); }   // random, positive and negative
+        long reps = (WORK / n > 0) ? WORK / n : 1;
+        double tRadix = 0, tIntro = 0, tStd = 0;
+        bool ok = true;
+
+        for(long k = 0; k < reps; k++)
+        {
+            a = input; b = input; c = input;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            radix.sort(a.data(), n);
+            tRadix += seconds_since(start);
+            start = chrono::steady_clock::now();
+            intro_sort(b.data(), int(n));
+            tIntro += seconds_since(start);
+            start = chrono::steady_clock::now();
+            sort(c.begin(), c.end());
+            tStd += seconds_since(start);
+            ok = ok && a == c && b == c;
+        }
+        double per = 1e9 / (double(reps) * n);
+        cout << n << "\t\t" << tRadix * per << "\t" << tIntro * per << "\t\t" << tStd * per
+             << (ok ? "" : "\tNOT SORTED") << endl;
+    }
+    return 0;
 }
+#endif
 
 
-// Bubble Sort ....................................................:
-
-#define SWAP(X, Y)      (X^=Y^=X^=Y)
-#define ORDER(X, Y)     ((X > Y) ? SWAP(X, Y) : 1)
 
-// Bubble sort variation: specifying minimums to the beginning of the list
-void BubbleSort(int *arr, int n)
+///* Benchmark: parallel_sort() scaling from 1 to 64 threads ...........................:
+#if 0
+int main()
 {
-    int i, j;
-    for (i = 0; i < n - 1; i++)
-        for (j = i + 1; j < n; j++)
-            ORDER(arr[i], arr[j]);
+    const long N = 100000000;
+    vector<int> input(N), arr;
+    unsigned r = 7;
+    for(long i = 0; i < N; i++)
+    {   r = r * 1103515245u + 12345u; input[i] = int(r ^ (r >> 15)); }
+
+    double t1 = 0;
+    for(int nThreads = 1; nThreads <= 64; nThreads *= 2)
+    {
+        arr = input;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        parallel_sort(arr.data(), N, nThreads);
+        double t = seconds_since(start);
+        if(nThreads == 1)
+            t1 = t;
+        cout << nThreads << " thread(s): " << t * 1e3 << " ms\t" << N / t / 1e6 << " M ints/s"
+             << "\t(speedup " << t1 / t << "x)"
+             << (is_sorted(arr.begin(), arr.end()) ? "" : "\tNOT SORTED") << endl;
+    }
+    cout << "(this machine has " << thread::hardware_concurrency() << " cores)" << endl << endl;
+
+    // few distinct keys: the equal keys must still be shared out between the threads
+    const char* names[] = { "all equal", "4 keys", "1000 keys" };
+    const int keys[] = { 1, 4, 1000 };
+    for(int k = 0; k < 3; k++)
+    {
+        for(long i = 0; i < N; i++)
+            arr[i] = int(input[i] & 0x7FFFFFFF) % keys[k];
+        double t[2];
+        for(int way = 0; way < 2; way++)
+        {
+            vector<int> b(arr);
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            parallel_sort(b.data(), N, way == 0 ? 1 : 8);
+            t[way] = seconds_since(start);
+            if(!is_sorted(b.begin(), b.end()))
+                cout << "NOT SORTED ";
+        }
+        cout << names[k] << ":	1 thread " << t[0] * 1e3 << " ms, 8 threads " << t[1] * 1e3 << " ms" << endl;
+    }
+    return 0;
 }
+#endif
 
 
-// Bubble sort variation: specifying maximums to the end of the list
-void BubbleSort2(int *arr, int n)
+
+///* Benchmark: Person_keysort() vs. sorting the pointers by getName() .................:
+#if 0
+int main()
 {
-    int i, j, swpd = 0;
-    for (i = 0; i < n - 1; i++)
+    void Person_bsort(Person**, int);
+    void Person_keysort(Person**, int);
+    const int N = 1000000;
+    const int N_BUBBLE = 5000;
+
+    vector<Person> people(N);
+    unsigned r = 3;
+    for(int i = 0; i < N; i++)          // random names of 4 to 15 letters, many sharing their first letters
     {
-        for (j = 0; j < n - i - 1; j++)
-            {   ORDER(arr[j], arr[j + 1]);  swpd = 1; }
-        if(!swpd) break;
-    }   
+        string name = (i % 3 == 0) ? "Abdelrahman" : "";
+        r = r * 1103515245u + 12345u;
+        for(int len = 4 + (r >> 16) % 12; int(name.size()) < len; )
+        {   r = r * 1103515245u + 12345u; name += char('a' + (r >> 16) % 26); }
+        people[i].setName(name);
+    }
+    vector<Person*> p1(N), p2(N);
+    for(int i = 0; i < N; i++)
+        p1[i] = p2[i] = &people[i];
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Person_keysort(p1.data(), N);
+    double tKey = seconds_since(start);
+
+    start = chrono::steady_clock::now();
+    stable_sort(p2.begin(), p2.end(), [](const Person* a, const Person* b) { return a->getName() < b->getName(); });
+    double tStd = seconds_since(start);
+
+    vector<Person*> p3(p2.begin(), p2.begin() + N_BUBBLE);
+    reverse(p3.begin(), p3.end());     // (the worst case for the bubble sort)
+    start = chrono::steady_clock::now();
+    Person_bsort(p3.data(), N_BUBBLE);
+    double tBubble = seconds_since(start);
+
+    cout << N << " persons:\tPerson_keysort " << tKey * 1e3 << " ms\tstd::stable_sort by name " << tStd * 1e3 << " ms"
+         << (p1 == p2 ? "" : "\tORDER DIFFERS")
+         << "\n" << N_BUBBLE << " persons:\tPerson_bsort " << tBubble * 1e3 << " ms" << endl;
+    return 0;
 }
+#endif
 
 
-void BubbleSort3(int *arr, int size)
+
+///* Benchmark: sorting blocks of 8 to 64 ints (ns per int) ............................:
+#if 0
+void book_bubble_sort(int *arr, int size)   // the book's BubbleSort3 (BubbleSort3 itself now calls intro_sort)
 {
-    int swapped = 0;
     for (int i = 0; i < size - 1; i++)
     {
+        int swapped = 0;
         for (int j = 0; j < size - i - 1; j++)
-        {
             if(arr[j] > arr[j + 1])
-            {   
-                arr[j] ^= arr[j+1] ^= arr[j] ^= arr[j+1];   // swap
-                swapped = 1;
-            } 
+            {   int t = arr[j]; arr[j] = arr[j + 1]; arr[j + 1] = t; swapped = 1; }
+        if(!swapped) break;
+    }
+}
+
+int main()
+{
+    const int TOTAL = 1 << 24;          // ints sorted for every block size
+    vector<int> input(TOTAL), a;
+    unsigned r = 11;
+    for(int i = 0; i < TOTAL; i++)
+    {   r = r * 1103515245u + 12345u; input[i] = int(r ^ (r >> 15)); }
+
+#if defined(__AVX2__)
+    cout << "network_sort(): AVX2 (8 ints per register)" << endl;
+#elif defined(__SSE2__)
+    cout << "network_sort(): SSE2 (4 ints per register)" << endl;
+#else
+    cout << "network_sort(): scalar" << endl;
+#endif
+    cout << "block\tns per int:  network\tinsertion\tbubble\tstd::sort" << endl;
+    for(int n = 8; n <= 64; n *= 2)
+    {
+        double t[4];
+        for(int method = 0; method < 4; method++)
+        {
+            a = input;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for(int b = 0; b + n <= TOTAL; b += n)
+            {
+                int* p = a.data() + b;
+                switch(method)
+                {
+                case 0: network_sort(p, p + n); break;
+                case 1: insertion_sort(p, p + n); break;
+                case 2: book_bubble_sort(p, n); break;
+                case 3: sort(p, p + n); break;
+                }
+            }
+            t[method] = seconds_since(start) * 1e9 / TOTAL;
+            for(int b = 0; b + n <= TOTAL; b += n)
+                if(!is_sorted(a.begin() + b, a.begin() + b + n))
+                {   cout << "NOT SORTED" << endl; return 1; }
         }
-        if(swapped == 0) {cout << "\nswapped"; break;}   
+        cout << n << "\t\t" << t[0] << "\t" << t[1] << "\t\t" << t[2] << "\t" << t[3] << endl;
     }
+    return 0;
 }
+#endif
 
 
-// String functions ................................................:
-void dispStr(char* str)
+
+///* Benchmark: heap calls and time per String (small-string optimization) .............:
+// operator new/delete are replaced to count every heap call made while the loops run.
+#if 0
+#include <new>
+#include <cstdlib>
+
+long heapCalls = 0;
+void* operator new(size_t n)
 {
-    while(*str) 
-        cout << *str++;
-    cout << endl;
+    heapCalls++;
+    void* p = malloc(n ? n : 1);
+    if(!p) throw bad_alloc();
+    return p;
 }
+void* operator new[](size_t n)          {   return operator new(n); }
+void operator delete(void* p) noexcept  {   if(p) { heapCalls++; free(p); } }
+void operator delete[](void* p) noexcept            {   operator delete(p); }
+void operator delete(void* p, size_t) noexcept      {   operator delete(p); }
+void operator delete[](void* p, size_t) noexcept    {   operator delete(p); }
 
-void cpyStr(char* dst, const char* src)
+class BookString                        // the book's String: 'new' for every string, no copy constructor
 {
-    while(*src)
-        *dst++ = *src++;
-    *dst = 0;
+private:
+    char *str;
+public:
+    BookString(const char *s)
+        {   str = new char[strlen(s) + 1]; strcpy(str, s); }
+    ~BookString()
+        {   delete[] str; }
+    int size() const
+        {   return strlen(str); }
+};
+
+int main()
+{
+    const int N = 2000000;
+    const char* texts[] = { "Hello", "Who knows nothing", "Who knows nothing, doubts every thing." };
+    const char* volatile src;
+    long sink = 0;
+
+    cout << "length\tclass\t\t\theap calls per loop\tns per loop" << endl;
+    for(int t = 0; t < 3; t++)
+    {
+        src = texts[t];
+        long calls;
+        chrono::steady_clock::time_point start;
+
+        calls = heapCalls;  start = chrono::steady_clock::now();
+        for(int i = 0; i < N; i++)
+        {   BookString a(src); sink += a.size(); }
+        cout << strlen(texts[t]) << "\tbook String (ctor)\t" << double(heapCalls - calls) / N << "\t\t\t" << seconds_since(start) * 1e9 / N << endl;
+
+        calls = heapCalls;  start = chrono::steady_clock::now();
+        for(int i = 0; i < N; i++)
+        {   String a(src); sink += a.size(); }
+        cout << strlen(texts[t]) << "\tString (ctor)\t\t" << double(heapCalls - calls) / N << "\t\t\t" << seconds_since(start) * 1e9 / N << endl;
+
+        // construct, copy, move, assign: 4 strings per loop
+        calls = heapCalls;  start = chrono::steady_clock::now();
+        for(int i = 0; i < N; i++)
+        {
+            String a(src);
+            String b(a);
+            String c(move(b));
+            String d;
+            d = c;
+            sink += d.size() + b.size();
+        }
+        cout << strlen(texts[t]) << "\tString (4 objects)\t" << double(heapCalls - calls) / N << "\t\t\t" << seconds_since(start) * 1e9 / N << endl;
+
+        calls = heapCalls;  start = chrono::steady_clock::now();
+        for(int i = 0; i < N; i++)
+        {
+            string a(src);
+            string b(a);
+            string c(move(b));
+            string d;
+            d = c;
+            sink += d.size() + b.size();
+        }
+        cout << strlen(texts[t]) << "\tstd::string (4 objects)\t" << double(heapCalls - calls) / N << "\t\t\t" << seconds_since(start) * 1e9 / N << endl;
+    }
+
+    // copies must own their characters
+    String s1 = "Who knows nothing, doubts every thing.";
+    String s2 = s1, s3 = "short";
+    s3 = s1;
+    s1 = "x";
+    cout << endl << s1.c_str() << " | " << s2.c_str() << " | " << s3.c_str() << endl;
+    cout << (sink ? "" : " ") << endl;
+    return 0;
 }
+#endif
 
 
-// Person Bubble Sort..............................................:
-void Person_bsort(Person** pp, int n)
+
+///* Benchmark: C-string functions, one char at a time vs <cstring> vs simd_cstring.h (8 B to 1 MB) ...:
+// First checks the fast_ functions against <cstring> on strings that end right before an unreadable page,
+// at every alignment (a read past that page would crash), then times them (GB/s).
+#if 0
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+size_t byte_strlen(const char* s)
+{   const char* p = s; while(*p) p++; return p - s; }
+int byte_strcmp(const char* a, const char* b)
+{   while(*a && *a == *b) { a++; b++; } return (unsigned char)*a - (unsigned char)*b; }
+const char* byte_strchr(const char* s, int ch)
+{   for( ; *s != (char)ch; s++) if(!*s) return NULL; return s; }
+
+bool check_near_page_end()
 {
-    void order(Person**, Person**);         // We will change the ptr to Person. So, we need to pass a ptr to it (ptr to ptr)
-    int i, j;
-    for (i = 0; i < n - 1; i++)
-        for (j = i + 1; j < n; j++)
-            {   order(&pp[i], &pp[j]); }
-        // or:  order(pp + i, pp + j); 
+    const int PAGE = 4096;
+    char* mem;
+#if defined(__unix__) || defined(__APPLE__)
+    mem = (char*)mmap(NULL, 3 * PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    mprotect(mem + 2 * PAGE, PAGE, PROT_NONE);          // the guard page
+#else
+    mem = new char[3 * PAGE];
+#endif
+    char* end = mem + 2 * PAGE;                         // last '\0' goes at end[-1]
+    char other[2 * PAGE];
+    for(int len = 0; len < 600; len++)
+    {
+        char* s = end - len - 1;
+        for(int j = 0; j < len; j++)
+            s[j] = 'a' + (j * 7 + len) % 26;
+        s[len] = '\0';
+        if(fast_strlen(s) != (size_t)len || fast_strchr(s, '#') != NULL || fast_strchr(s, 0) != s + len)
+            return false;
+        if(len > 0 && fast_strchr(s, s[len - 1]) != strchr(s, s[len - 1]))
+            return false;
+        for(int off = 0; off < 64; off += 5)            // compare with a copy at other alignments, equal and not
+        {
+            char* t = other + off;
+            memcpy(t, s, len + 1);
+            if(fast_strcmp(s, t) != 0 || fast_strcmp(t, s) != 0)
+                return false;
+            if(len > 0)
+            {
+                t[len / 2] ^= 1;
+                if((fast_strcmp(s, t) < 0) != (strcmp(s, t) < 0) || (fast_strcmp(t, s) < 0) != (strcmp(t, s) < 0))
+                    return false;
+            }
+            char copy[800];
+            memset(copy, '#', sizeof(copy));
+            char* d = copy + off % 7;
+            if(strcmp(fast_strcpy(d, s), s) != 0)
+                return false;
+            for(char* q = d + len + 1; q < copy + sizeof(copy); q++)    // nothing written past the '\0'
+                if(*q != '#')
+                    return false;
+        }
+    }
+    return true;
 }
 
-void order(Person** pp1, Person** pp2)
+int main()
 {
-    if((*pp1)->getName() > (*pp2)->getName())
+    if(!check_near_page_end())
+    {   cout << "WRONG RESULT" << endl; return 1; }
+    cout << "page-end checks: ok (" << CSTR_VEC << " chars per load)" << endl << endl;
+
+    cout << "size\t\tfunction\tbyte loop\t<cstring>\tsimd_cstring.h\t(GB/s)" << endl;
+    const long sizes[] = { 8, 64, 512, 4096, 65536, 1 << 20 };
+    for(int k = 0; k < 6; k++)
     {
-        Person* temp = *pp1;
-        *pp1 = *pp2;
-        *pp2 = temp;
+        long size = sizes[k];
+        string a(size - 1, 'x'), b(size - 1, 'x');
+        char* dst = new char[size];
+        const char* volatile pa = a.c_str();            // (volatile: keeps calls in the timing loops)
+        const char* volatile pb = b.c_str();
+        long reps = max(10L, (200L << 20) / size);
+        long sink = 0;
+        double t[4][3];
+
+        for(int fn = 0; fn < 4; fn++)
+            for(int impl = 0; impl < 3; impl++)
+            {
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                for(long r = 0; r < reps; r++)
+                {
+                    switch(fn * 3 + impl)
+                    {
+                    case 0:  sink += byte_strlen(pa); break;
+                    case 1:  sink += strlen(pa); break;
+                    case 2:  sink += fast_strlen(pa); break;
+                    case 3:  { char* d = dst; const char* s = pa; while(*s) *d++ = *s++; *d = 0; sink += dst[0]; } break;
+                    case 4:  sink += strcpy(dst, pa)[0]; break;
+                    case 5:  sink += fast_strcpy(dst, pa)[0]; break;
+                    case 6:  sink += byte_strcmp(pa, pb); break;
+                    case 7:  sink += strcmp(pa, pb); break;
+                    case 8:  sink += fast_strcmp(pa, pb); break;
+                    case 9:  sink += byte_strchr(pa, 'y') != NULL; break;
+                    case 10: sink += strchr(pa, 'y') != NULL; break;
+                    case 11: sink += fast_strchr(pa, 'y') != NULL; break;
+                    }
+                }
+                t[fn][impl] = double(size) * reps / seconds_since(start) / 1e9;
+            }
+        const char* names[] = { "strlen", "strcpy", "strcmp", "strchr" };
+        for(int fn = 0; fn < 4; fn++)
+            cout << size << "\t\t" << names[fn] << "\t\t" << t[fn][0] << "\t\t" << t[fn][1] << "\t\t" << t[fn][2] << endl;
+        cout << (sink == 42 ? " " : "");
+        delete[] dst;
     }
-}       
-
+    return 0;
+}
+#endif
@@ -1,6 +1,10 @@
 #include <iostream>
 #include <cstring>
 #include <typeinfo>
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <shared_mutex>        // shared_timed_mutex, shared_lock (C++14)
 using namespace std;
 
 /// Polymorphism ///
@@ -714,16 +718,17 @@ public:
 class StrWithCount
 {
 private:
-    int count;
+    atomic<int> count;                  // atomic, so Strings sharing this string can live in different threads
     char* str;
     friend class String;                // now class 'String' has access to all class 'StrWithCount' members
+    friend class StringPool;
 
-    StrWithCount(char* s)               // one-arg constructor
+    StrWithCount(const char* s)         // one-arg constructor
     {
         int length = strlen(s);         // acquire string length
         str = new char[length + 1];     // allocate memory for the new string
         strcpy(str, s);                 // copy actual string provided as argument to that memory
-        count = 1;                      // instantiate count at 1
+        count.store(1, memory_order_relaxed);   // instantiate count at 1
     }
 
     ~StrWithCount()
@@ -735,28 +740,61 @@ class String
 {
 private:
     StrWithCount* pSWC;
+
+    void release()                      // this object stops pointing to its 'StrWithCount'
+    {
+        if(pSWC && pSWC->count.fetch_sub(1, memory_order_release) == 1)
+        {
+            atomic_thread_fence(memory_order_acquire);
+            delete pSWC;                // (We don’t need brackets on delete because we’re deleting only a single strCount object.) 
+        }
+    }
+    void detach()                       // copy-on-write: get our own copy before changing the string
+    {
+        if(pSWC->count.load(memory_order_acquire) != 1)
+        {
+            StrWithCount* own = new StrWithCount(pSWC->str);
+            release();
+            pSWC = own;
+        }
+    }
+    String(StrWithCount* p)             // share an existing 'StrWithCount' (used by StringPool)
+    {
+        pSWC = p;
+        pSWC->count.fetch_add(1, memory_order_relaxed);
+    }
+    friend class StringPool;
 public:
     String()                            // no-arg constructor
-    {   pSWC = new StrWithCount((char*)"NULL"); }
-    String(char* s)                     // one-arg constructor
+    {   pSWC = new StrWithCount("NULL"); }
+    String(const char* s)               // one-arg constructor
     {   pSWC = new StrWithCount(s); }
     String(const String& S)             // Copy constructor
     {   
         pSWC = S.pSWC;                  // Both the new object and the argument points to the same allocated memory
-        (pSWC->count)++;                // increment the count of pointers to that memory
+        pSWC->count.fetch_add(1, memory_order_relaxed);     // increment the count of pointers to that memory
     }
-    ~String()
+    String(String&& S) noexcept         // Move constructor: take over the argument's pointer, no counting needed
     {
-        if(pSWC->count == 1)
-            delete pSWC;                // (We don’t need brackets on delete because we’re deleting only a single strCount object.) 
-        else
-            (pSWC->count)--;
+        pSWC = S.pSWC;
+        S.pSWC = NULL;
     }
+    ~String()
+    {   release(); }
     void display()
     { 
         cout << pSWC->str;
         cout << " (address = " << pSWC << ")";
     }
+    const char* c_str() const
+    {   return pSWC->str; }
+    bool same_as(const String& S) const // equal interned strings share one 'StrWithCount', so comparing pointers is enough
+    {   return pSWC == S.pSWC; }
+    void set_char(int index, char ch)   // the only way to change the string, so it detaches first
+    {
+        detach();
+        pSWC->str[index] = ch;
+    }
     String& operator = (const String& S)
     {
         // if(this == &S)                  // handles the situation where S = S; otherwise, (if this object is the only that points to the 'StrWithCount') then, the 'StrWithCount' will be deleted and the program may crash.
@@ -765,19 +803,165 @@ public:
         // OR:
         if(this != &S)
         {
-            if(pSWC->count == 1)        // if this object is the last that points to a string
-                delete pSWC;            // delete it (deallocate memory of 'StrWithCount')
-            else
-                (pSWC->count)--;
-            
+            S.pSWC->count.fetch_add(1, memory_order_relaxed);   // increment the counter of the argument 'StrWithCount'
+            release();                  // delete our 'StrWithCount' if this object is the last that points to it
             pSWC = S.pSWC;              // assign the argument to this object
-            (pSWC->count)++;            // increment the counter of the argument 'StrWithCount'
         }
 
         return *this;
     }
+    String& operator = (String&& S) noexcept
+    {
+        if(this != &S)
+        {
+            release();
+            pSWC = S.pSWC;
+            S.pSWC = NULL;
+        }
+        return *this;
+    }
 };
 
+/* Note: Sharing Strings between threads
+    With a plain 'int count', two threads copying (or destroying) Strings that share one 'StrWithCount' 
+        can both read the same count and write back the same value, so it gets lost → leaks or double deletes.
+    ► 'count' is an atomic<int>, so every increment and decrement happens as one indivisible step:
+        • Increments can be 'relaxed': a new copy is made from a String that is already holding a count, so nothing can be deleted meanwhile.
+        • Decrements are 'release', and the thread that drops the count to 0 does an 'acquire' fence before deleting,
+            so every use of the string in other threads happens before it is deleted.
+    ► Copy-on-write: set_char() first detaches (makes its own copy) if the string is shared,
+        so a writer never changes the characters other Strings (maybe in other threads) are reading.
+    • A moved-from String holds a NULL pointer; it can only be destroyed or assigned to.
+*/
+
+
+/// Interning: One Buffer for Equal Strings ///
+/*
+    Copies of a String share one 'StrWithCount', but two equal strings made separately (ex. read from a file) still get two.
+    ► A 'StringPool' keeps one 'StrWithCount' for every different string content it has seen:
+        intern("Ahmed") returns a String sharing the pool's buffer, so all the "Ahmed"s in the program are one buffer,
+        and comparing two interned strings is comparing two pointers (same_as()).
+    ► It is a hash table split into SHARDS independent parts (chosen by the hash), each with its own lock,
+        so threads interning different strings rarely wait for each other.
+        • Lookups of strings already in the pool (the common case) take the lock 'shared', so many can run at once.
+        • Only adding a new string takes it 'unique', and checks again (another thread may have added it meanwhile).
+        • (shared_timed_mutex is C++14; the plain shared_mutex would need C++17 for the same job.)
+    • The pool holds one count on each of its strings, so they live as long as the pool does,
+        and writing to an interned String (set_char()) detaches as usual; the pooled copy never changes.
+*/
+class StringPool
+{
+private:
+    enum { SHARDS = 64 };
+    struct Shard
+    {
+        shared_timed_mutex lock;
+        vector<StrWithCount*> slots;    // open addressing (linear probing), size is a power of 2
+        vector<size_t> hashes;          // hash of each slot, compared before the strings
+        long used;
+        long bytes;                     // memory of the strings in this shard
+        Shard() : slots(16, (StrWithCount*)NULL), hashes(16), used(0), bytes(0) { }
+    };
+    Shard shards[SHARDS];
+
+    static size_t hash_of(const char* s)    // FNV-1a
+    {
+        size_t h = 14695981039346656037ULL;
+        while(*s)
+            {   h = (h ^ (unsigned char)*s++) * 1099511628211ULL; }
+        return h;
+    }
+    static StrWithCount* lookup(Shard& sh, const char* s, size_t h, size_t& slot)
+    {
+        size_t mask = sh.slots.size() - 1;
+        for(slot = (h >> 8) & mask; sh.slots[slot]; slot = (slot + 1) & mask)
+        {
+            if(sh.hashes[slot] == h && strcmp(sh.slots[slot]->str, s) == 0)
+                return sh.slots[slot];
+        }
+        return NULL;                    // 'slot' is now the empty slot where s belongs
+    }
+    static void grow(Shard& sh)         // double the table when it's half full
+    {
+        vector<StrWithCount*> oldSlots(sh.slots.size() * 2, (StrWithCount*)NULL);
+        vector<size_t> oldHashes(sh.hashes.size() * 2);
+        oldSlots.swap(sh.slots);
+        oldHashes.swap(sh.hashes);
+        size_t mask = sh.slots.size() - 1;
+        for(size_t j = 0; j < oldSlots.size(); j++)
+        {
+            if(!oldSlots[j])
+                continue;
+            size_t slot = (oldHashes[j] >> 8) & mask;
+            while(sh.slots[slot])
+                {   slot = (slot + 1) & mask; }
+            sh.slots[slot] = oldSlots[j];
+            sh.hashes[slot] = oldHashes[j];
+        }
+    }
+public:
+    StringPool() { }
+    ~StringPool()
+    {
+        for(int i = 0; i < SHARDS; i++)
+            for(size_t j = 0; j < shards[i].slots.size(); j++)
+                if(shards[i].slots[j] && shards[i].slots[j]->count.fetch_sub(1, memory_order_acq_rel) == 1)
+                    delete shards[i].slots[j];
+    }
+    String intern(const char* s)
+    {
+        size_t h = hash_of(s);
+        Shard& sh = shards[h % SHARDS];
+        size_t slot;
+        {
+            shared_lock<shared_timed_mutex> lock(sh.lock);
+            if(StrWithCount* p = lookup(sh, s, h, slot))
+                return String(p);
+        }
+        unique_lock<shared_timed_mutex> lock(sh.lock);
+        if(StrWithCount* p = lookup(sh, s, h, slot))     // added by another thread meanwhile?
+            return String(p);
+        if(2 * (sh.used + 1) > (long)sh.slots.size())
+        {
+            grow(sh);
+            lookup(sh, s, h, slot);
+        }
+        StrWithCount* p = new StrWithCount(s);          // count = 1 is the pool's own count
+        sh.slots[slot] = p;
+        sh.hashes[slot] = h;
+        sh.used++;
+        sh.bytes += sizeof(StrWithCount) + strlen(s) + 1;
+        return String(p);
+    }
+    long size()                         // number of different strings
+    {
+        long n = 0;
+        for(int i = 0; i < SHARDS; i++)
+        {
+            shared_lock<shared_timed_mutex> lock(shards[i].lock);
+            n += shards[i].used;
+        }
+        return n;
+    }
+    long memory()                       // bytes used by the pooled strings (not counting the table itself)
+    {
+        long n = 0;
+        for(int i = 0; i < SHARDS; i++)
+        {
+            shared_lock<shared_timed_mutex> lock(shards[i].lock);
+            n += shards[i].bytes;
+        }
+        return n;
+    }
+};
+
+// the global pool
+String intern(const char* s)
+{
+    static StringPool pool;
+    return pool.intern(s);
+}
+
 // ♦ The UML object diagram shows the relationship of a group of objects at a specific point in a program’s operation.
 
 
@@ -869,6 +1053,8 @@ void displayName(Base_Polymorphic* pB)
 
 
 
+// main()
+#if 1
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 int main()
 {
@@ -1217,6 +1403,7 @@ int main()
 
     return 0;
 }
+#endif
 
 
 void func(Zeta) {}
@@ -1233,4 +1420,155 @@ Zeta func(void) { return Zeta(0); }
     Coercion is also known as (implicit or explicit) casting.
 */
 // Using Virtual tables
-// why there is no virtual constructor? Because derived calsses must have their own constructors anyway
\ No newline at end of file
+// why there is no virtual constructor? Because derived calsses must have their own constructors anyway
+
+
+///* Benchmark: copying shared Strings from many threads ....................................:
+// Every thread copies (and destroys) Strings that share one 'StrWithCount', then writes to some copies (copy-on-write).
+// operator new/delete are replaced to check that every 'new' is deleted exactly once at the end.
+#if 0
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+atomic<long> newCalls(0), deleteCalls(0);
+void* operator new(size_t n)
+{
+    newCalls.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(n ? n : 1);
+    if(!p) throw bad_alloc();
+    return p;
+}
+void* operator new[](size_t n)          {   return operator new(n); }
+void operator delete(void* p) noexcept  {   if(p) { deleteCalls.fetch_add(1, memory_order_relaxed); free(p); } }
+void operator delete[](void* p) noexcept            {   operator delete(p); }
+void operator delete(void* p, size_t) noexcept      {   operator delete(p); }
+void operator delete[](void* p, size_t) noexcept    {   operator delete(p); }
+
+void copier(const String* shared, int copies, long* sink)
+{
+    String local[16];
+    long n = 0;
+    for(int i = 0; i < copies; i++)
+    {
+        String s(*shared);              // copy: one relaxed increment
+        local[i & 15] = s;              // assign: increment + decrement
+        n += s.c_str()[0];              // s destroyed: one decrement
+    }
+    for(int j = 0; j < 16; j++)         // writers detach from the shared string
+    {
+        local[j].set_char(0, 'w');
+        n += local[j].c_str()[0];
+    }
+    *sink = n;
+}
+
+int main()
+{
+    const int COPIES = 4000000;         // per thread
+    int maxThreads = max(4u, thread::hardware_concurrency());
+
+    cout << "threads\tcopies/s (millions)\tnew - delete" << endl;
+    for(int nThreads = 1; nThreads <= maxThreads; nThreads *= 2)
+    {
+        long before = newCalls - deleteCalls;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        {
+            String shared = "When the fox preaches, look to your geese.";
+            vector<thread> threads;
+            vector<long> sinks(nThreads);
+            for(int t = 0; t < nThreads; t++)
+                threads.push_back(thread(copier, &shared, COPIES, &sinks[t]));
+            for(int t = 0; t < nThreads; t++)
+                threads[t].join();
+            if(shared.c_str()[0] != 'W')
+                {   cout << "shared string was changed by a writer!" << endl;   return 1; }
+        }
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        long leaked = (newCalls - deleteCalls) - before;
+        cout << nThreads << "\t" << 2.0 * COPIES * nThreads / secs / 1e6 << "\t\t\t" << leaked << endl;
+        if(leaked != 0)
+            {   cout << (leaked > 0 ? "LEAK" : "DOUBLE DELETE") << endl;   return 1; }
+    }
+    return 0;
+}
+#endif
+
+
+
+///* Benchmark: interning millions of duplicate names .............................................:
+// N names drawn (skewed, like real names) from a smaller set of different names, interned from 1 to N threads.
+#if 0
+#include <thread>
+#include <chrono>
+#include <string>
+
+void intern_slice(StringPool* pool, const vector<string>* names, const vector<int>* picks, long first, long last, vector<String>* out)
+{
+    for(long i = first; i < last; i++)
+        out->push_back(pool->intern((*names)[(*picks)[i]].c_str()));
+}
+
+int main()
+{
+    const int DISTINCT = 100000;
+    const long N = 4000000;
+    vector<string> names(DISTINCT);
+    vector<int> picks(N);
+    unsigned r = 7;
+    for(int i = 0; i < DISTINCT; i++)
+    {
+        int len = 6 + i % 9;
+        for(int c = 0; c < len; c++)
+            {   r = r * 1103515245u + 12345u; names[i] += char('a' + (r >> 16) % 26); }
+        names[i] += to_string(i);                   // keep them different
+    }
+    long plainBytes = 0;                            // memory if every name had its own StrWithCount
+    for(long i = 0; i < N; i++)
+    {
+        r = r * 1103515245u + 12345u;
+        long x = (r >> 8) % DISTINCT;
+        picks[i] = int(x * x / DISTINCT);           // small indices are picked much more often
+        plainBytes += sizeof(StrWithCount) + names[picks[i]].size() + 1;
+    }
+
+    // without a pool: a new 'StrWithCount' for every name
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    {
+        vector<String> plain;
+        plain.reserve(N);
+        for(long i = 0; i < N; i++)
+            plain.push_back(String(names[picks[i]].c_str()));
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "String(char*) without pool: " << N / secs / 1e6 << " M/s" << endl << endl;
+
+    int maxThreads = max(4u, thread::hardware_concurrency());
+    cout << "threads\tintern lookups/s (millions)\tdifferent strings\tmemory saved (MB)" << endl;
+    for(int nThreads = 1; nThreads <= maxThreads; nThreads *= 2)
+    {
+        StringPool pool;
+        vector<vector<String> > out(nThreads);
+        for(int t = 0; t < nThreads; t++)
+            out[t].reserve(N / nThreads + 1);
+
+        start = chrono::steady_clock::now();
+        vector<thread> threads;
+        for(int t = 0; t < nThreads; t++)
+            threads.push_back(thread(intern_slice, &pool, &names, &picks, N * t / nThreads, N * (t + 1) / nThreads, &out[t]));
+        for(int t = 0; t < nThreads; t++)
+            threads[t].join();
+        secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << nThreads << "\t" << N / secs / 1e6 << "\t\t\t\t" << pool.size() << "\t\t\t"
+             << (plainBytes - pool.memory()) / 1048576.0 << " of " << plainBytes / 1048576.0 << endl;
+
+        // equal names must share one buffer, different names must not
+        String a = pool.intern(names[42].c_str()), b = pool.intern(string(names[42]).c_str()), c = pool.intern(names[43].c_str());
+        if(!a.same_as(b) || a.same_as(c) || strcmp(a.c_str(), names[42].c_str()) != 0)
+            {   cout << "interning is broken!" << endl;   return 1; }
+    }
+    return 0;
+}
+#endif
@@ -3,9 +3,12 @@
 #include <iomanip>          // for manipulators
 // #include <strstream>
 #include <string>
+#include <cstring>
 #include <cstdlib>
 #include <process.h>        // for exit()
 #include <typeinfo>         // for typeid()
+#include <string_view>      // (C++17)
+#include <charconv>         // for to_chars() (C++17)
 
 using namespace std;
 
@@ -78,6 +81,101 @@ using namespace std;
 
 
 
+/// ♦ Formatting Whole Records Before Writing Them ♦ ////////////////////////////////////////
+/*
+    Displaying a record item by item (cout << "Name: " << name << endl; ...) makes one stream call per item,
+        and every 'endl' flushes the stream: one write to the device (a system call) per line.
+    ► RecordBuilder formats a whole record (or many records) into one contiguous buffer first:
+        • It starts with a buffer inside the object, and only grows into 'new' memory (doubling) for long output,
+            so formatting a record needs no heap allocation per field (or at all).
+        • view() hands the formatted text back as a string_view (pointer + length, no copy),
+            so the caller writes it with one call: cout.write(v.data(), v.size()).
+        • clear() empties it, keeping its memory for the next batch.
+    ► Numbers are formatted with to_chars() (no locale, no stream state), in the same format cout uses by default.
+    • string_view and to_chars() (for floating-point too) are C++17, so this chapter needs C++17 (-std=c++17).
+    • Only this chapter's records use it (Distance, Person, Employee and the file tools):
+        the show_dist() / showData() / putData() of the earlier chapters print one record per user action,
+        where one write instead of a few saves nothing noticeable, and they stay the book's plain cout examples.
+*/
+class RecordBuilder
+{
+private:
+    enum { INLINE = 256 };
+    char local[INLINE];
+    char* buf;
+    size_t len, cap;
+
+    void reserve(size_t more)
+    {
+        if(len + more <= cap)
+            return;
+        size_t newCap = max(2 * cap, len + more);
+        char* b = new char[newCap];
+        memcpy(b, buf, len);
+        if(buf != local)
+            delete[] buf;
+        buf = b;
+        cap = newCap;
+    }
+    RecordBuilder(const RecordBuilder&);                // not copyable
+    RecordBuilder& operator=(const RecordBuilder&);
+public:
+    RecordBuilder() : buf(local), len(0), cap(INLINE)
+    {   }
+    ~RecordBuilder()
+    {
+        if(buf != local)
+            delete[] buf;
+    }
+    RecordBuilder& operator<<(string_view s)
+    {
+        reserve(s.size());
+        memcpy(buf + len, s.data(), s.size());
+        len += s.size();
+        return *this;
+    }
+    RecordBuilder& operator<<(const char* s)
+    {   return *this << string_view(s); }
+    RecordBuilder& operator<<(char ch)
+    {
+        reserve(1);
+        buf[len++] = ch;
+        return *this;
+    }
+    RecordBuilder& operator<<(long n)
+    {
+        reserve(24);
+        len = to_chars(buf + len, buf + cap, n).ptr - buf;
+        return *this;
+    }
+    RecordBuilder& operator<<(unsigned long n)
+    {
+        reserve(24);
+        len = to_chars(buf + len, buf + cap, n).ptr - buf;
+        return *this;
+    }
+    RecordBuilder& operator<<(int n)
+    {   return *this << (long)n; }
+    RecordBuilder& operator<<(double d)                 // like cout: %g with 6 significant digits
+    {
+        reserve(32);
+        len = to_chars(buf + len, buf + cap, d, chars_format::general, 6).ptr - buf;
+        return *this;
+    }
+    string_view view() const
+    {   return string_view(buf, len); }
+    size_t size() const
+    {   return len; }
+    void clear()
+    {   len = 0; }
+};
+
+// write the whole builder with one call
+inline ostream& operator<<(ostream& os, const RecordBuilder& rb)
+{   return os.write(rb.view().data(), rb.view().size()); }
+
+
+
 // Error-Free Distance Class:
 int isFeet(string);
 
@@ -94,8 +192,10 @@ public:
         feet = static_cast<int>(fltFeets);
         inches = 12 * (fltFeets - feet);
     }
+    void show_dist(RecordBuilder& rb) const
+    {   rb << feet << "\' " << inches << '\"'; }
     void show_dist() const
-    {   cout << feet << "\' " << inches << "\""; }
+    {   RecordBuilder rb; show_dist(rb); cout << rb; }
     void get_dist();
 };
 
@@ -207,11 +307,27 @@ public:
         cout << "Enter name: "; cin >> name; 
         cout << "Enter age: ";  cin >> age; 
     }
+    void showData(RecordBuilder& rb) const          // append this record to rb
+    {
+        rb << "Name: " << name << '\n';
+        rb << "Age: " << age << '\n';
+    }
     void showData() const
     {
-        cout << "Name: " << name << endl;
-        cout << "Age: " << age << endl;
+        RecordBuilder rb;
+        showData(rb);
+        cout << rb << flush;                        // one write, one flush (instead of one per line)
+    }
+    void setData(const char* n, short a)            // set data without asking the user
+    {
+        strncpy(name, n, sizeof(name) - 1);
+        name[sizeof(name) - 1] = '\0';
+        age = a;
     }
+    const char* getName() const
+        {   return name; }
+    short getAge() const
+        {   return age; }
     void diskIn(string, int);                       // read from file
     void diskOut(string);                           // write to file
     static int diskCount(string);                         // return number of persons in file
@@ -272,11 +388,13 @@ public:
         cout << "\nEnter last name: ";          cin >> name;
         cout << "\nEnter employee number: ";    cin >> number;
     }
-    virtual void putData()
+    virtual void putData(RecordBuilder& rb)         // append this employee to rb
     {
-        cout << "\n Name: " << name;
-        cout << "\n Employee number: " << number;
+        rb << "\n Name: " << name;
+        rb << "\n Employee number: " << number;
     }
+    void putData()
+    {   RecordBuilder rb; putData(rb); cout << rb; }
     virtual employee_type getType();               // get type
     static void add();                              // add an employee
     static void display();                       // display all employee
@@ -304,11 +422,12 @@ public:
         cout << "\nEnter title: ";              cin >> title;
         cout << "\nEnter golf club dues: ";     cin >> dues;
     }
-    void putData()
+    using Employee::putData;                        // (else putData(rb) would hide putData())
+    void putData(RecordBuilder& rb)
     {
-        Employee::putData();
-        cout << "\nTitle: " << title;
-        cout << "\nGolf club dues: " << dues;
+        Employee::putData(rb);
+        rb << "\nTitle: " << title;
+        rb << "\nGolf club dues: " << dues;
     }
 };
 
@@ -326,10 +445,11 @@ public:
         Employee::getData();
         cout << "\nEnter number of publications: ";     cin >> pubs;
     }
-    void putData()
+    using Employee::putData;                        // (else putData(rb) would hide putData())
+    void putData(RecordBuilder& rb)
     {
-        Employee::putData();
-        cout << "\nNumber of publications: " << pubs;
+        Employee::putData(rb);
+        rb << "\nNumber of publications: " << pubs;
     }
 };
 
@@ -363,19 +483,21 @@ employee_type Employee::getType()
 // display all employees
 void Employee::display()
 {
+    RecordBuilder rb;                               // all employees are formatted here, then written at once
     for (int i = 0; i < total; i++)
     {
-        cout << (i+1);
+        rb << (i+1);
         switch(arrpEmp[i]->getType())
         {
-        case t_manager:     cout << ". Type: Mnager";       break;
-        case t_scientist:   cout << ". Type: Scientist";    break;
-        case t_laborer:     cout << ". Type: Laborer";      break;
-        default:            cout << ". Unknown type";
+        case t_manager:     rb << ". Type: Mnager";       break;
+        case t_scientist:   rb << ". Type: Scientist";    break;
+        case t_laborer:     rb << ". Type: Laborer";      break;
+        default:            rb << ". Unknown type";
         }
-        arrpEmp[i]->putData();                      // display employee data
-        cout << endl;
+        arrpEmp[i]->putData(rb);                    // display employee data
+        rb << '\n';
     }
+    cout << rb << flush;
 }
 
 // write all current memory objects to file
@@ -418,6 +540,8 @@ void Employee::write(string fname)
 
 
 
+// main()
+#if 1
 //////////////////////////////////////////////////////////////////////////////////////////////
 int main()
 {
@@ -1181,3 +1305,367 @@ int main()
         
     return 0;
 }
+#endif
+
+
+//-----------------------------------------------------------------------------------------------------
+/// ♦ External Merge Sort for Files of Person Records ♦ ////////////////////////////////////////////////
+/*
+    When a file of fixed-size records (like group.dat or personFile.dat) is bigger than the memory we have,
+        we can't read all of it into an array and sort it. Instead:
+    ► Run Phase:    read the file in big sequential chunks (one "run" at a time), sort each run in memory by name,
+                    and write it to its own temporary file.
+    ► Merge Phase:  read all runs at the same time, a buffer-full from each, and keep writing the smallest
+                    record among the fronts of the runs to the output file.
+                    → A "loser tree" finds that smallest record in log2(k) comparisons for k runs:
+                        each inner node keeps the loser of the match played there, and the overall winner sits on top.
+                        When the winner is replaced by the next record of its run, only the matches on its path are replayed.
+                    → If there are too many runs to give each one a decent buffer, runs are merged in groups (more passes).
+
+    • Both phases only do big sequential reads and writes, which is what disks are fastest at.
+
+    Usage:
+        extsort --gen <file> <count>                        write <count> random Person records
+        extsort <in> <out> [memory MB] [run MB]             sort <in> by name into <out> (defaults: 64 MB, 64 MB)
+        extsort --check <file>                              check that <file> is sorted
+*/
+#if 0
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>                   // for remove()
+
+const long MERGE_BUF_MIN = 256 * 1024;              // smallest useful read buffer per run while merging
+
+inline bool name_less(const Person& a, const Person& b)
+    {   return strncmp(a.getName(), b.getName(), 40) < 0; }
+
+// reads one sorted run through a buffer of whole records
+class RunReader
+{
+private:
+    ifstream in;
+    vector<Person> buf;
+    long count;                                     // records now in buf
+    long pos;                                       // next record in buf
+public:
+    RunReader(string fname, long bufRecords) : buf(bufRecords), count(0), pos(0)
+    {
+        in.open(fname, ios::binary);
+        if(!in)
+            { cerr << "\nCould not open run " << fname;   exit(1); }
+        refill();
+    }
+    bool done() const
+        {   return pos >= count; }
+    const Person& front() const
+        {   return buf[pos]; }
+    void advance()
+    {
+        if(++pos == count)
+            refill();
+    }
+    void refill()
+    {
+        in.read(reinterpret_cast<char*>(&buf[0]), buf.size() * sizeof(Person));
+        count = in.gcount() / sizeof(Person);
+        pos = 0;
+    }
+};
+
+// loser tree over k runs: node 0 holds the winner (smallest front), nodes 1..k-1 hold the losers
+class LoserTree
+{
+private:
+    vector<RunReader*>& runs;
+    vector<int> tree;
+    int k;
+
+    bool beats(int a, int b) const                  // does run a's front come before run b's front?
+    {
+        if(runs[a]->done())     return false;       // an empty run loses to everything
+        if(runs[b]->done())     return true;
+        int cmp = strncmp(runs[a]->front().getName(), runs[b]->front().getName(), 40);
+        return cmp < 0 || (cmp == 0 && a < b);      // equal names keep run order (stable)
+    }
+public:
+    LoserTree(vector<RunReader*>& r) : runs(r), tree(r.size()), k(r.size())
+    {
+        vector<int> winner(2 * k);
+        for(int i = 0; i < k; i++)                  // leaf i is node k+i
+            winner[k + i] = i;
+        for(int n = k - 1; n >= 1; n--)             // play the matches bottom-up
+        {
+            int a = winner[2 * n], b = winner[2 * n + 1];
+            winner[n] = beats(a, b) ? a : b;
+            tree[n]   = beats(a, b) ? b : a;
+        }
+        tree[0] = (k == 1) ? 0 : winner[1];
+    }
+    bool empty() const
+        {   return runs[tree[0]]->done(); }
+    const Person& top() const
+        {   return runs[tree[0]]->front(); }
+    void pop()                                      // take the winner, then replay its path to the top
+    {
+        int w = tree[0];
+        runs[w]->advance();
+        for(int n = (k + w) / 2; n >= 1; n /= 2)
+        {
+            if(beats(tree[n], w))
+                swap(tree[n], w);
+        }
+        tree[0] = w;
+    }
+};
+
+class ExternalSorter
+{
+private:
+    long memBudget;                                 // bytes of records we may hold at once
+    long runBytes;                                  // bytes sorted in memory per run
+    long long bytesRead, bytesWritten;
+    int passes;
+
+    // merge the given runs into outName, deleting them afterwards
+    void merge(const vector<string>& names, string outName)
+    {
+        long bufRecords = max(1L, memBudget / (long)(names.size() + 1) / (long)sizeof(Person));
+        vector<RunReader*> runs;
+        for(size_t j = 0; j < names.size(); j++)
+            runs.push_back(new RunReader(names[j], bufRecords));
+
+        ofstream out(outName, ios::trunc | ios::binary);
+        if(!out)
+            { cerr << "\nCould not open output file " << outName;   exit(1); }
+        vector<Person> outBuf(bufRecords);
+        long n = 0;
+        for(LoserTree lt(runs); !lt.empty(); lt.pop())
+        {
+            bytesRead += sizeof(Person);            // a merge reads every record it writes
+            outBuf[n++] = lt.top();
+            if(n == bufRecords)
+            {
+                out.write(reinterpret_cast<char*>(&outBuf[0]), n * sizeof(Person));
+                bytesWritten += n * sizeof(Person);
+                n = 0;
+            }
+        }
+        out.write(reinterpret_cast<char*>(&outBuf[0]), n * sizeof(Person));
+        bytesWritten += n * sizeof(Person);
+        if(!out)
+            { cerr << "\nCould not write to file " << outName;   exit(1); }
+
+        for(size_t j = 0; j < names.size(); j++)
+        {
+            delete runs[j];
+            remove(names[j].c_str());
+        }
+    }
+public:
+    ExternalSorter(long memoryBytes, long runSizeBytes)
+        : memBudget(memoryBytes), runBytes(min(runSizeBytes, memoryBytes)), bytesRead(0), bytesWritten(0), passes(0)
+    {   }
+
+    // returns the number of records sorted
+    long sort(string inName, string outName)
+    {
+        ifstream in(inName, ios::binary);
+        if(!in)
+            { cerr << "\nCould not open input file " << inName;   exit(1); }
+
+        // ► Run phase
+        vector<Person> run(max(1L, runBytes / (long)sizeof(Person)));
+        vector<string> names;
+        long total = 0;
+        while(true)
+        {
+            in.read(reinterpret_cast<char*>(&run[0]), run.size() * sizeof(Person));
+            long n = in.gcount() / sizeof(Person);
+            if(n == 0)
+                break;
+            bytesRead += n * sizeof(Person);
+            total += n;
+            stable_sort(run.begin(), run.begin() + n, name_less);
+
+            string name = outName + ".run" + to_string(names.size());
+            ofstream out(name, ios::trunc | ios::binary);
+            out.write(reinterpret_cast<char*>(&run[0]), n * sizeof(Person));
+            if(!out)
+                { cerr << "\nCould not write to file " << name;   exit(1); }
+            bytesWritten += n * sizeof(Person);
+            names.push_back(name);
+        }
+        in.close();
+        vector<Person>().swap(run);                 // give the run memory back before merging
+        passes = 1;
+
+        if(names.empty())                           // empty input → empty output
+            {   ofstream out(outName, ios::trunc | ios::binary);   return 0; }
+
+        // ► Merge phase: merge groups of fanIn runs until one group is left
+        long fanIn = max(2L, memBudget / MERGE_BUF_MIN - 1);
+        int level = 0;
+        while((long)names.size() > fanIn)
+        {
+            vector<string> next;
+            for(size_t first = 0; first < names.size(); first += fanIn)
+            {
+                vector<string> group(names.begin() + first, names.begin() + min(names.size(), first + fanIn));
+                string name = outName + ".merge" + to_string(level) + "_" + to_string(next.size());
+                merge(group, name);
+                next.push_back(name);
+            }
+            names.swap(next);
+            level++;
+            passes++;
+        }
+        if(names.size() == 1)                       // the whole file fit in one run: no merge needed
+        {
+            remove(outName.c_str());
+            rename(names[0].c_str(), outName.c_str());
+            return total;
+        }
+        merge(names, outName);
+        passes++;
+        return total;
+    }
+    long long io_bytes() const
+        {   return bytesRead + bytesWritten; }
+    int io_passes() const                           // run phase + merge passes
+        {   return passes; }
+};
+
+void generate(string fname, long count)
+{
+    ofstream out(fname, ios::trunc | ios::binary);
+    vector<Person> buf(4096);
+    srand(1);
+    for(long done = 0; done < count; )
+    {
+        long n = min((long)buf.size(), count - done);
+        for(long j = 0; j < n; j++)
+        {
+            char name[13];
+            int len = 5 + rand() % 8;
+            for(int c = 0; c < len; c++)
+                name[c] = 'a' + rand() % 26;
+            name[len] = '\0';
+            buf[j].setData(name, rand() % 100);
+        }
+        out.write(reinterpret_cast<char*>(&buf[0]), n * sizeof(Person));
+        done += n;
+    }
+}
+
+bool check(string fname, long& count)
+{
+    ifstream in(fname, ios::binary);
+    Person prev, cur;
+    count = 0;
+    while(in.read(reinterpret_cast<char*>(&cur), sizeof(cur)))
+    {
+        if(count > 0 && name_less(cur, prev))
+            return false;
+        prev = cur;
+        count++;
+    }
+    return true;
+}
+
+int main(int argc, char const *argv[])
+{
+    if(argc == 4 && string(argv[1]) == "--gen")
+    {
+        generate(argv[2], atol(argv[3]));
+        return 0;
+    }
+    if(argc == 3 && string(argv[1]) == "--check")
+    {
+        long count;
+        bool ok = check(argv[2], count);
+        cout << count << " records, " << (ok ? "sorted" : "NOT sorted") << endl;
+        return ok ? 0 : 1;
+    }
+    if(argc < 3)
+    {
+        cerr << "usage: " << argv[0] << " <in> <out> [memory MB] [run MB]\n"
+             << "       " << argv[0] << " --gen <file> <count>\n"
+             << "       " << argv[0] << " --check <file>\n";
+        return 1;
+    }
+
+    long memMB = (argc > 3) ? atol(argv[3]) : 64;
+    long runMB = (argc > 4) ? atol(argv[4]) : memMB;
+    ExternalSorter sorter(memMB << 20, runMB << 20);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    long total = sorter.sort(argv[1], argv[2]);
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    double mb = sorter.io_bytes() / 1048576.0;
+    cout << "sorted " << total << " records (" << total * sizeof(Person) / 1048576.0 << " MB) in "
+         << secs << " s, " << sorter.io_passes() << " passes over the data" << endl;
+    cout << "I/O: " << mb << " MB read+written, " << mb / secs << " MB/s" << endl;
+    return 0;
+}
+#endif
+
+
+//-----------------------------------------------------------------------------------------------------
+/// Benchmark: printing 10 million Person records, item by item vs with a RecordBuilder ///
+/*
+    Run it with the output redirected (the times go to cerr):
+        records > /dev/null                 both ways
+        records old > old.txt               only the book's way (cout << ... << endl per line)
+        records new > new.txt               only with RecordBuilder (then: cmp old.txt new.txt)
+*/
+#if 0
+#include <chrono>
+
+void book_showData(const Person& p)             // showData() as the book wrote it
+{
+    cout << "Name: " << p.getName() << endl;
+    cout << "Age: " << p.getAge() << endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    const long N = 10000000;
+    const int KINDS = 1000;
+    string way = (argc > 1) ? argv[1] : "both";
+
+    Person people[KINDS];
+    for(int j = 0; j < KINDS; j++)
+    {
+        string name = "person" + to_string(j * 7919 % 100000);
+        people[j].setData(name.c_str(), j % 100);
+    }
+
+    if(way == "old" || way == "both")
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for(long i = 0; i < N; i++)
+            book_showData(people[i % KINDS]);
+        cerr << "item by item with endl:\t" << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s" << endl;
+    }
+
+    if(way == "new" || way == "both")
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        RecordBuilder rb;
+        for(long i = 0; i < N; i++)
+        {
+            people[i % KINDS].showData(rb);
+            if(rb.size() >= 64 * 1024)          // write 64 KB at a time
+            {
+                cout << rb;
+                rb.clear();
+            }
+        }
+        cout << rb << flush;
+        cerr << "RecordBuilder, 64 KB writes:\t" << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s" << endl;
+    }
+    return 0;
+}
+#endif
@@ -1,5 +1,16 @@
 #include <iostream>
 #include <string>
+#include <algorithm>
+#include <utility>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#if defined(__SSE2__)
+#include <immintrin.h>          // SIMD intrinsics (SSE2/AVX2)
+#endif
 
 
 using namespace std;
@@ -81,6 +92,290 @@ int find(aType* array, int size, aType value)
     return -1;
 } 
 
+/// Specializing a Template for Some Types ///
+/*
+    find() above compares one element per step. For arrays of numbers, the CPU can compare a whole vector register
+        (16 bytes with SSE2, 32 with AVX2: 32 chars or 8 ints or 4 doubles) with the value in one instruction.
+    ► find_vector() does that:
+        • 'key' holds the value copied into every lane of a register,
+        • each step compares 4 registers of the array with it and turns the results into bit masks (movemask),
+        • the first step with any bit set has the match: the lowest set bit gives its index.
+    ► A full specialization 'template <> int find(int*, int, int)' tells the compiler:
+        "for int arrays, use this body instead of the general one". Other types (string, Distance...) still use the template.
+    • Doubles compare like ==: NaN is never found, and 0.0 finds -0.0.
+    • The lowest set bit is found with __builtin_ctz() (GCC and Clang): other compilers use the plain loop.
+    • vec_splat() and vec_eq_mask() choose the instruction with 'if constexpr', so this part needs C++17 (-std=c++17).
+*/
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#define FIND_VECTOR
+#define FIND_CTZ(x) __builtin_ctz(x)
+#endif
+
+#if defined(FIND_VECTOR)
+#if defined(__AVX2__)
+typedef __m256i VecReg;
+#else
+typedef __m128i VecReg;
+#endif
+
+template <class T>
+inline VecReg vec_splat(T value)                        // value in every lane
+{
+#if defined(__AVX2__)
+    if constexpr (is_same<T, float>::value)     return _mm256_castps_si256(_mm256_set1_ps(value));
+    else if constexpr (is_same<T, double>::value)   return _mm256_castpd_si256(_mm256_set1_pd(value));
+    else if constexpr (sizeof(T) == 1)          return _mm256_set1_epi8((char)value);
+    else if constexpr (sizeof(T) == 2)          return _mm256_set1_epi16((short)value);
+    else if constexpr (sizeof(T) == 4)          return _mm256_set1_epi32((int)value);
+    else                                        return _mm256_set1_epi64x((long long)value);
+#else
+    if constexpr (is_same<T, float>::value)     return _mm_castps_si128(_mm_set1_ps(value));
+    else if constexpr (is_same<T, double>::value)   return _mm_castpd_si128(_mm_set1_pd(value));
+    else if constexpr (sizeof(T) == 1)          return _mm_set1_epi8((char)value);
+    else if constexpr (sizeof(T) == 2)          return _mm_set1_epi16((short)value);
+    else if constexpr (sizeof(T) == 4)          return _mm_set1_epi32((int)value);
+    else                                        return _mm_set1_epi64x((long long)value);
+#endif
+}
+
+template <class T>
+inline unsigned vec_eq_mask(const T* p, VecReg key)    // one bit per byte of the lanes equal to key
+{
+#if defined(__AVX2__)
+    VecReg v = _mm256_loadu_si256((const __m256i*)p), eq;
+    if constexpr (is_same<T, float>::value)     eq = _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(v), _mm256_castsi256_ps(key), _CMP_EQ_OQ));
+    else if constexpr (is_same<T, double>::value)   eq = _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(v), _mm256_castsi256_pd(key), _CMP_EQ_OQ));
+    else if constexpr (sizeof(T) == 1)          eq = _mm256_cmpeq_epi8(v, key);
+    else if constexpr (sizeof(T) == 2)          eq = _mm256_cmpeq_epi16(v, key);
+    else if constexpr (sizeof(T) == 4)          eq = _mm256_cmpeq_epi32(v, key);
+    else                                        eq = _mm256_cmpeq_epi64(v, key);
+    return (unsigned)_mm256_movemask_epi8(eq);
+#else
+    VecReg v = _mm_loadu_si128((const __m128i*)p), eq;
+    if constexpr (is_same<T, float>::value)     eq = _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(v), _mm_castsi128_ps(key)));
+    else if constexpr (is_same<T, double>::value)   eq = _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(v), _mm_castsi128_pd(key)));
+    else if constexpr (sizeof(T) == 1)          eq = _mm_cmpeq_epi8(v, key);
+    else if constexpr (sizeof(T) == 2)          eq = _mm_cmpeq_epi16(v, key);
+    else if constexpr (sizeof(T) == 4)          eq = _mm_cmpeq_epi32(v, key);
+#if defined(__SSE4_1__)
+    else                                        eq = _mm_cmpeq_epi64(v, key);
+#else
+    else
+    {
+        eq = _mm_cmpeq_epi32(v, key);           // (SSE2 has no 64-bit compare: both halves must be equal)
+        eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, 0xB1));
+    }
+#endif
+    return (unsigned)_mm_movemask_epi8(eq);
+#endif
+}
+#endif
+
+// the types find_vector() can compare: integers of 1, 2, 4 or 8 bytes, float and double (not long double)
+template <class T>
+struct vector_findable : integral_constant<bool, (is_integral<T>::value && (sizeof(T) == 1 || sizeof(T) == 2 ||
+                                                  sizeof(T) == 4 || sizeof(T) == 8))
+                                                 || is_same<T, float>::value || is_same<T, double>::value> { };
+
+// index of the first element equal to value, or -1
+template <class T>
+long find_vector(const T* array, long size, T value)
+{
+    static_assert(vector_findable<T>::value, "find_vector(): no vector compare for this type");
+    long j = 0;
+#if defined(FIND_VECTOR)
+    const long PER = sizeof(VecReg) / sizeof(T);        // elements per register
+    VecReg key = vec_splat(value);
+    for( ; j + 4 * PER <= size; j += 4 * PER)
+    {
+        unsigned m0 = vec_eq_mask(array + j, key),           m1 = vec_eq_mask(array + j + PER, key);
+        unsigned m2 = vec_eq_mask(array + j + 2 * PER, key), m3 = vec_eq_mask(array + j + 3 * PER, key);
+        if(m0 | m1 | m2 | m3)
+        {
+            if(m0)  return j + FIND_CTZ(m0) / sizeof(T);
+            if(m1)  return j + PER + FIND_CTZ(m1) / sizeof(T);
+            if(m2)  return j + 2 * PER + FIND_CTZ(m2) / sizeof(T);
+            return j + 3 * PER + FIND_CTZ(m3) / sizeof(T);
+        }
+    }
+    for( ; j + PER <= size; j += PER)
+    {
+        if(unsigned m = vec_eq_mask(array + j, key))
+            return j + FIND_CTZ(m) / sizeof(T);
+    }
+#endif
+    for( ; j < size; j++)                               // the last few (or all, without FIND_VECTOR)
+    {
+        if(array[j] == value)
+            return j;
+    }
+    return -1;
+}
+
+template <> int find(char* array, int size, char value)         {   return find_vector(array, size, value); }
+template <> int find(short* array, int size, short value)       {   return find_vector(array, size, value); }
+template <> int find(int* array, int size, int value)           {   return find_vector(array, size, value); }
+template <> int find(long* array, int size, long value)         {   return find_vector(array, size, value); }
+template <> int find(long long* array, int size, long long value)   {   return find_vector(array, size, value); }
+template <> int find(float* array, int size, float value)       {   return find_vector(array, size, value); }
+template <> int find(double* array, int size, double value)     {   return find_vector(array, size, value); }
+
+/// Searching Huge Arrays with Several Threads ///
+/*
+    For hundreds of millions of elements, even find_vector() takes a good part of a second on one core.
+    ► parallel_find() cuts the array into blocks of BLOCK elements and lets nThreads threads scan them:
+        • Each thread takes the next block from a shared atomic counter (next.fetch_add(1)),
+            so the blocks are handed out from the start of the array to its end, and a slow thread doesn't hold back the others.
+        • A thread that finds a match stores its index in the shared atomic 'best' if it is lower than the one already there.
+        • Every block starting at or after 'best' can only hold later matches: the thread that takes one just stops.
+            → The work after the first match is cancelled, and the blocks before it are all still scanned,
+                so the result is the lowest matching index, the same as find().
+    • Blocks of numbers are scanned with find_vector(), other types (and long double) with a plain loop.
+    • The threads are started for each call (some tens of µs), so small arrays are searched on the calling thread.
+*/
+template <class aType>
+long find_in_block(const aType* array, long size, const aType& value)
+{
+    if constexpr (vector_findable<aType>::value)
+        return find_vector(array, size, value);
+    else
+    {
+        for(long j = 0; j < size; j++)
+        {
+            if(array[j] == value)
+                return j;
+        }
+        return -1;
+    }
+}
+
+template <class aType>
+long parallel_find(const aType* array, long size, aType value, int nThreads = 0)
+{
+    const long BLOCK = 1 << 16;
+    if(nThreads <= 0)
+        nThreads = max(1u, thread::hardware_concurrency());
+    if(nThreads == 1 || size <= 2 * BLOCK)
+        return find_in_block(array, size, value);
+
+    atomic<long> next(0);                   // next block to hand out
+    atomic<long> best(size);                // lowest match found so far (size: none yet)
+    auto work = [&]()
+    {
+        for(;;)
+        {
+            long start = next.fetch_add(1, memory_order_relaxed) * BLOCK;
+            if(start >= size || start >= best.load(memory_order_relaxed))
+                return;                     // past the end, or past a match already found
+            long j = find_in_block(array + start, min(BLOCK, size - start), value);
+            if(j >= 0)
+            {
+                long found = start + j, old = best.load(memory_order_relaxed);
+                while(found < old && !best.compare_exchange_weak(old, found, memory_order_relaxed))
+                    ;                       // (old is reloaded by a failed exchange)
+                return;                     // this thread's next blocks would come after it
+            }
+        }
+    };
+    vector<thread> threads;
+    for(int t = 1; t < nThreads; t++)
+        threads.push_back(thread(work));
+    work();                                 // the calling thread is one of the workers
+    for(size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+    long result = best.load();
+    return (result < size) ? result : -1;
+}
+
+/// Searching Sorted Arrays ///
+/*
+    When the array is already sorted, find() doesn't have to look at every element: 
+        binary search halves the part of the array that can hold the value at each step: log2(n) steps.
+    ► find_sorted(): a branchless binary search.
+        • A normal binary search has an if/else at each step that the CPU can only guess (50% wrong),
+            and every wrong guess costs ~15-20 cycles.
+        • Here each step only chooses between two pointers (base or base + half), which the compiler
+            turns into a conditional move: no guess, no penalty.
+        • It also asks the memory (prefetch) for both places the next step might look at, before it knows which one.
+    ► EytzingerIndex: for big tables, a copy of the sorted array laid out like a binary heap (the Eytzinger / BFS order):
+        • element 1 is the middle, elements 2 and 3 are the middles of both halves, then 4..7, and so on,
+            so element k's children are 2k and 2k+1.
+        • The first levels of the search are the first few elements, which stay in the cache.
+        • The 16 elements (of 4 bytes) that the search can reach 4 steps later are neighbours (2^4 * k .. 2^4 * k + 15),
+            so one prefetch of that cache line hides most of the memory wait.
+    Both return the index (in the sorted array) of the first element equal to value, or -1: like find().
+*/
+template <class aType>
+int find_sorted(const aType* array, int size, aType value)
+{
+    if(size <= 0)
+        return -1;
+    const aType* base = array;
+    int n = size;
+    while(n > 1)                            // the first element >= value is in [base, base + n]
+    {
+        int half = n / 2;
+#if defined(__GNUC__)
+        __builtin_prefetch(base + half / 2);
+        __builtin_prefetch(base + half + half / 2);
+#endif
+        base = (base[half] < value) ? base + half : base;
+        n -= half;
+    }
+    base += (*base < value);
+    return (base < array + size && *base == value) ? int(base - array) : -1;
+}
+
+template <class aType>
+class EytzingerIndex
+{
+private:
+    vector<aType> store;                    // (a few extra elements to align the table to a cache line)
+    aType* eyt;                             // eyt[1..n] in Eytzinger order
+    vector<int> pos;                        // pos[k]: index of eyt[k] in the sorted array
+    int n;
+    enum { LINE = 64, AHEAD = (64 / sizeof(aType) > 1) ? 64 / sizeof(aType) : 1 };   // elements per cache line
+
+    int build(const aType* sorted, int i, int k)    // in-order walk of the implicit tree
+    {
+        if(k <= n)
+        {
+            i = build(sorted, i, 2 * k);
+            eyt[k] = sorted[i];
+            pos[k] = i++;
+            i = build(sorted, i, 2 * k + 1);
+        }
+        return i;
+    }
+public:
+    EytzingerIndex(const aType* sorted, int size) : store(size + 1 + LINE / sizeof(aType) + 1), pos(size + 1), n(size)
+    {
+        uintptr_t addr = (uintptr_t)store.data();
+        eyt = store.data() + ((LINE - addr % LINE) % LINE) / sizeof(aType);
+        build(sorted, 0, 1);
+    }
+    int find(aType value) const
+    {
+        size_t k = 1;
+        while(k <= (size_t)n)
+        {
+#if defined(__GNUC__)
+            __builtin_prefetch(eyt + k * AHEAD);    // the cache line this search reaches log2(AHEAD) steps later
+#endif
+            k = 2 * k + (eyt[k] < value);
+        }
+        // k went right (1) at every level below the answer, then left (0) once at it: drop those bits
+#if defined(__GNUC__)
+        k >>= __builtin_ffsll(~k);
+#else
+        while(k & 1)
+            k >>= 1;
+        k >>= 1;
+#endif
+        return (k != 0 && eyt[k] == value) ? pos[k] : -1;
+    }
+};
+
 /// Function Template Arguments Consistency ///
 /*
     if you call this function, give all the same-template arguments only one Type.
@@ -183,9 +478,15 @@ class Stack_2
         int top;                    // number of the top of the stack
     public:
         Stack_2();                  // constructor
+        Stack_2(const Stack_2& s);              // copy only the live items
+        Stack_2(Stack_2&& s);                   // move only the live items
+        Stack_2& operator=(const Stack_2& s);
+        Stack_2& operator=(Stack_2&& s);
         void push(Type var);        // put a new object in stack
         Type pop();                 // take number off the stack
-        Stack_2<Type> sorted();
+        void sort();                            // sort in place, pop() then gives the smallest first
+        Stack_2<Type>& sorted() &;              // sort in place and return this stack
+        Stack_2<Type> sorted() &&;              // sort a temporary and move it out
 };
 
 template <class Type>
@@ -206,26 +507,74 @@ Type Stack_2<Type>::pop()
     return st[top--];
 }
 
-// If the externally defined member function is returning an object of this class class, you would write:
 template <class Type>
-Stack_2<Type> Stack_2<Type>::sorted()
+Stack_2<Type>::Stack_2(const Stack_2& s)
 {
-    Type temp;
-    for(int i = 0; i <= top; i++)
+    top = s.top;
+    copy(s.st, s.st + top + 1, st);
+}
+
+template <class Type>
+Stack_2<Type>::Stack_2(Stack_2&& s)
+{
+    top = s.top;
+    move(s.st, s.st + top + 1, st);
+    s.top = -1;
+}
+
+template <class Type>
+Stack_2<Type>& Stack_2<Type>::operator=(const Stack_2& s)
+{
+    if(this != &s)
     {
-        for(int j = 0; j <= top; j++)
-        {
-            if(st[i] > st[j])
-            {
-                temp = st[i];
-                st[i] = st[j];
-                st[j] = temp;
-            }
-        }
+        top = s.top;
+        copy(s.st, s.st + top + 1, st);
     }
     return *this;
 }
 
+template <class Type>
+Stack_2<Type>& Stack_2<Type>::operator=(Stack_2&& s)
+{
+    if(this != &s)
+    {
+        top = s.top;
+        move(s.st, s.st + top + 1, st);
+        s.top = -1;
+    }
+    return *this;
+}
+
+// Only the live range [0, top] is sorted, largest at the bottom so that pop() returns the smallest item first.
+// std::sort() is O(n log n) and only swaps (moves) the items, so a stack of strings is sorted without copying one.
+template <class Type>
+void Stack_2<Type>::sort()
+{
+    std::sort(st, st + top + 1, [](const Type& a, const Type& b) { return a > b; });
+}
+
+// If the externally defined member function is returning an object of this class class, you would write:
+template <class Type>
+Stack_2<Type>& Stack_2<Type>::sorted() &
+{
+    sort();
+    return *this;
+}
+
+template <class Type>
+Stack_2<Type> Stack_2<Type>::sorted() &&
+{
+    sort();
+    return std::move(*this);
+}
+
+/* Note: sorted() used to be a full n² double loop over the stack, then returned *this by value,
+    which copied all MAX items even when the stack held only three.
+    • s.sorted() on a named stack now sorts it in place and returns a reference (no copy at all).
+    • Stack_2<Type>(...).sorted() or move(s).sorted() on a temporary moves the sorted items out.
+    • Copying and moving a Stack_2 only touches the live items [0, top], not the whole array.
+*/
+
 /*
     Int<Type> Int<Type>::xfunc(Int arg)
     { }
@@ -235,6 +584,212 @@ Stack_2<Type> Stack_2<Type>::sorted()
 
 
 
+/// A Stack That Grows: Small Buffer, Heap, and an Allocator Argument ///
+/*
+    Stack and Stack_2 always hold 'Type st[MAX]':
+        • A Stack<string> constructs 100 strings before the first push, and copies them all when it is copied.
+        • The 101st push writes past the end of the array (undefined behavior).
+    ► GrowStack<Type, N, Alloc> only constructs the items that are pushed:
+        • The first N items live in a raw buffer inside the object itself (no heap at all for small stacks).
+        • When that is full, it takes a heap block twice as big (then 4N, 8N...) from the allocator,
+            moves the items there and frees the old block: n pushes cost n moves at most in all (amortized O(1)).
+        • Alloc is the same as the third argument of vector<Type, Alloc>: anything with allocate()/deallocate()
+            (an arena, a pool...). allocator_traits<Alloc> fills in the rest with the defaults.
+        • pop() on an empty stack throws GrowStack::Empty, like Stack_3 below.
+*/
+template <class Type, int N = 16, class Alloc = allocator<Type> >
+class GrowStack
+{
+    private:
+        typedef allocator_traits<Alloc> Traits;
+        enum { LOCAL = (N > 0) ? N : 1 };
+        alignas(Type) unsigned char local[LOCAL * sizeof(Type)];    // the first items (raw memory: nothing constructed)
+        Type* st;                   // local or a heap block
+        Type* last;                 // one past the top item
+        Type* end;                  // one past the room in st
+        Alloc alloc;                // (pointers rather than int counts: a store to a Stack<int> item can't change them)
+
+        bool onHeap() const
+            {   return st != (const Type*)local; }
+        void grow(int newCap);
+        void release();             // destroy the items and free the heap block
+        void moveFrom(GrowStack& s);
+    public:
+        class Empty { };            // exception class
+
+        explicit GrowStack(const Alloc& a = Alloc()) : st((Type*)local), last(st), end(st + LOCAL), alloc(a)
+            { }
+        GrowStack(const GrowStack& s);
+        GrowStack(GrowStack&& s) noexcept(is_nothrow_move_constructible<Type>::value);
+        GrowStack& operator=(const GrowStack& s);
+        GrowStack& operator=(GrowStack&& s);
+        ~GrowStack()
+            {   release(); }
+
+        void push(const Type& var)
+            {   emplace(var); }
+        void push(Type&& var)
+            {   emplace(std::move(var)); }
+        template <class... Args>
+        Type& emplace(Args&&... args);  // construct the new item in place
+        Type pop();                     // take the top item off the stack
+        Type& top()
+            {   if(last == st) throw Empty(); return last[-1]; }
+        int size() const
+            {   return int(last - st); }
+        bool empty() const
+            {   return last == st; }
+        int capacity() const
+            {   return int(end - st); }
+        size_t heapBytes() const        // memory taken from the allocator (not counting what the items own)
+            {   return onHeap() ? capacity() * sizeof(Type) : 0; }
+        void clear()
+            {   while(last != st) Traits::destroy(alloc, --last); }
+};
+
+template <class Type, int N, class Alloc>
+void GrowStack<Type, N, Alloc>::grow(int newCap)
+{
+    Type* block = Traits::allocate(alloc, newCap);
+    int count = size(), j = 0;
+    try
+    {
+        for( ; j < count; j++)      // move, or copy if moving could throw (then a failure leaves the stack as it was)
+            Traits::construct(alloc, block + j, move_if_noexcept(st[j]));
+    }
+    catch(...)
+    {
+        while(j > 0)
+            Traits::destroy(alloc, block + --j);
+        Traits::deallocate(alloc, block, newCap);
+        throw;
+    }
+    release();
+    st = block;
+    last = st + count;
+    end = st + newCap;
+}
+
+template <class Type, int N, class Alloc>
+void GrowStack<Type, N, Alloc>::release()
+{
+    clear();
+    if(onHeap())
+        Traits::deallocate(alloc, st, capacity());
+    st = last = (Type*)local;
+    end = st + LOCAL;
+}
+
+template <class Type, int N, class Alloc>
+template <class... Args>
+Type& GrowStack<Type, N, Alloc>::emplace(Args&&... args)
+{
+    if(last == end)
+    {
+        // (args may refer to an item of this stack: build the new item first)
+        Type var(std::forward<Args>(args)...);
+        grow(2 * capacity());
+        Traits::construct(alloc, last, std::move(var));
+    }
+    else
+        Traits::construct(alloc, last, std::forward<Args>(args)...);
+    return *last++;
+}
+
+template <class Type, int N, class Alloc>
+Type GrowStack<Type, N, Alloc>::pop()
+{
+    if(last == st)
+        throw Empty();
+    Type var(std::move(last[-1]));
+    Traits::destroy(alloc, --last);
+    return var;
+}
+
+// Takes s's heap block as it is, or moves its items one by one when they are in its local buffer.
+template <class Type, int N, class Alloc>
+void GrowStack<Type, N, Alloc>::moveFrom(GrowStack& s)
+{
+    if(s.onHeap())
+    {
+        st = s.st;
+        last = s.last;
+        end = s.end;
+    }
+    else
+    {
+        for(Type* p = s.st; p != s.last; p++)
+            Traits::construct(alloc, last++, std::move(*p));
+        s.clear();
+    }
+    s.st = s.last = (Type*)s.local;
+    s.end = s.st + LOCAL;
+}
+
+template <class Type, int N, class Alloc>
+GrowStack<Type, N, Alloc>::GrowStack(const GrowStack& s)
+    : st((Type*)local), last(st), end(st + LOCAL), alloc(Traits::select_on_container_copy_construction(s.alloc))
+{
+    if(s.size() > capacity())
+        grow(s.capacity());
+    for(Type* p = s.st; p != s.last; p++)
+        push(*p);
+}
+
+template <class Type, int N, class Alloc>
+GrowStack<Type, N, Alloc>::GrowStack(GrowStack&& s) noexcept(is_nothrow_move_constructible<Type>::value)
+    : st((Type*)local), last(st), end(st + LOCAL), alloc(std::move(s.alloc))
+{
+    moveFrom(s);
+}
+
+template <class Type, int N, class Alloc>
+GrowStack<Type, N, Alloc>& GrowStack<Type, N, Alloc>::operator=(const GrowStack& s)
+{
+    if(this != &s)
+    {
+        release();
+        if(Traits::propagate_on_container_copy_assignment::value)
+            alloc = s.alloc;
+        if(s.size() > capacity())
+            grow(s.capacity());
+        for(Type* p = s.st; p != s.last; p++)
+            push(*p);
+    }
+    return *this;
+}
+
+template <class Type, int N, class Alloc>
+GrowStack<Type, N, Alloc>& GrowStack<Type, N, Alloc>::operator=(GrowStack&& s)
+{
+    if(this != &s)
+    {
+        release();
+        if(Traits::propagate_on_container_move_assignment::value)
+            alloc = std::move(s.alloc);
+        if(Traits::propagate_on_container_move_assignment::value || alloc == s.alloc)
+            moveFrom(s);            // our allocator can free s's block
+        else
+        {
+            if(s.size() > capacity())
+                grow(s.capacity());
+            for(Type* p = s.st; p != s.last; p++)
+                push(std::move(*p));
+            s.release();
+        }
+    }
+    return *this;
+}
+
+/* Note: the stack's memory, for sizeof(Type) = S:
+    • Stack<Type>:          100 * S in the object, always, with 100 constructed items.
+    • GrowStack<Type, N>:   N * S in the object (+ 3 pointers), and only when more than N items are pushed,
+                            a heap block of 2N, 4N... items (at most twice the number of items).
+    → Choose N so that most stacks never leave the local buffer, but keep in mind that
+        a GrowStack made inside a function puts all N * S bytes on the function's stack frame.
+*/
+
+
 /// A Linked list Class Using Templates ///
 // Page 696 (722 / 1038) -to be continued ...
 
@@ -740,3 +1295,571 @@ int main(int argc, char const *argv[])
     - If there is no exception handler that matches the exception thrown, the program is unceremoniously terminated by the operating system.
 */
 
+
+
+//-----------------------------------------------------------------------------------------------------
+/// Benchmark: Stack_2::sorted() vs The Old n² sorted() ///....................................................:
+// Tracked counts its own copies and moves, so it shows the new sorted() only moves the items around.
+// The old version is rebuilt on a plain array: the n² double loop plus the by-value copy of all MAX items.
+#if 0
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+
+struct Tracked
+{
+    string s;
+    static long copies;
+    static long moves;
+
+    Tracked() { }
+    Tracked(const string& str) : s(str) { }
+    Tracked(const Tracked& t) : s(t.s)
+        {   copies++; }
+    Tracked(Tracked&& t) : s(std::move(t.s))
+        {   moves++; }
+    Tracked& operator=(const Tracked& t)
+        {   s = t.s; copies++; return *this; }
+    Tracked& operator=(Tracked&& t)
+        {   s = std::move(t.s); moves++; return *this; }
+    bool operator>(const Tracked& t) const
+        {   return s > t.s; }
+};
+long Tracked::copies = 0;
+long Tracked::moves = 0;
+
+void book_sorted(Tracked* st, int top, Tracked* result)
+{
+    Tracked temp;
+    for(int i = 0; i <= top; i++)
+    {
+        for(int j = 0; j <= top; j++)
+        {
+            if(st[i] > st[j])
+            {
+                temp = st[i];
+                st[i] = st[j];
+                st[j] = temp;
+            }
+        }
+    }
+    for(int j = 0; j < MAX; j++)        // return *this by value copied the whole array
+        result[j] = st[j];
+}
+
+int main(int argc, char const *argv[])
+{
+    const int REPS = 2000;
+    srand(1);
+
+    cout << "items\tversion\t\tus/sort\tcopies/sort\tmoves/sort" << endl;
+    for(int n : {3, 10, 100})
+    {
+        vector<Tracked> data;
+        for(int j = 0; j < n; j++)      // 40-char strings, too long for the small-string buffer
+            data.push_back(Tracked(string(32, 'a' + rand() % 26) + to_string(rand())));
+
+        // the old sorted()
+        double secs = 0;
+        long copies = 0, moves = 0;
+        static Tracked arr[MAX], result[MAX];
+        for(int r = 0; r < REPS; r++)
+        {
+            for(int j = 0; j < n; j++)
+                arr[j] = data[j];
+            long c0 = Tracked::copies, m0 = Tracked::moves;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            book_sorted(arr, n - 1, result);
+            secs += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            copies += Tracked::copies - c0;
+            moves += Tracked::moves - m0;
+        }
+        cout << n << "\told n^2\t\t" << secs / REPS * 1e6 << "\t" << copies / REPS << "\t\t" << moves / REPS << endl;
+
+        // sorted() in place, and sorted() on a temporary moved into another stack
+        for(int variant = 0; variant < 2; variant++)
+        {
+            secs = 0; copies = 0; moves = 0;
+            for(int r = 0; r < REPS; r++)
+            {
+                Stack_2<Tracked>* stk = new Stack_2<Tracked>;
+                for(int j = 0; j < n; j++)
+                    stk->push(data[j]);
+                long c0 = Tracked::copies, m0 = Tracked::moves;
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                if(variant == 0)
+                    stk->sorted();
+                else
+                    Stack_2<Tracked> out = std::move(*stk).sorted();
+                secs += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                copies += Tracked::copies - c0;
+                moves += Tracked::moves - m0;
+                delete stk;
+            }
+            cout << n << (variant == 0 ? "\tsorted() &\t" : "\tsorted() &&\t")
+                 << secs / REPS * 1e6 << "\t" << copies / REPS << "\t\t" << moves / REPS << endl;
+        }
+    }
+
+    // pop order check: smallest first
+    Stack_2<Tracked> s;
+    s.push(Tracked("pear")); s.push(Tracked("apple")); s.push(Tracked("fig"));
+    s.sorted();
+    cout << endl << s.pop().s << " " << s.pop().s << " " << s.pop().s << endl;
+    return 0;
+}
+#endif
+
+
+//-----------------------------------------------------------------------------------------------------
+/// Benchmark: find() one element at a time vs the vector specializations (16 to 10^8 elements) ///
+// The value is not in the array, so both scan all of it (the worst case). Also checks every index for small arrays.
+#if 0
+#include <chrono>
+#include <vector>
+
+template <class aType>
+long book_find(aType* array, long size, aType value)        // the general template's loop
+{
+    for(long j = 0; j < size; j++)
+    {
+        if(array[j] == value)
+            return j;
+    }
+    return -1;
+}
+
+template <class T>
+bool check_positions()
+{
+    for(int n = 0; n < 200; n++)
+    {
+        vector<T> a(n, T(1));
+        if(find(a.data(), n, T(2)) != -1)
+            return false;
+        for(int k = 0; k < n; k++)
+        {
+            a[k] = T(2);
+            if(k + 1 < n)   a[n - 1] = T(2);        // a later match must not win
+            if(find(a.data(), n, T(2)) != k)
+                return false;
+            a[k] = T(1);
+            a[n - 1] = T(1);
+        }
+    }
+    return true;
+}
+
+template <class T>
+void bench(const char* typeName)
+{
+    cout << typeName << endl;
+    const long sizes[] = { 16, 256, 4096, 65536, 1 << 20, 1 << 24, 100000000 };
+    for(int k = 0; k < 7; k++)
+    {
+        long n = sizes[k];
+        vector<T> a(n, T(1));
+        T* volatile pa = a.data();
+        long reps = max(1L, 200000000L / n);
+        double t[2];
+        for(int way = 0; way < 2; way++)
+        {
+            long sink = 0;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for(long r = 0; r < reps; r++)
+                sink += (way == 0) ? book_find(pa, n, T(2)) : find_vector((const T*)pa, n, T(2));
+            t[way] = chrono::duration<double>(chrono::steady_clock::now() - start).count() * 1e9 / ((double)reps * n);
+            if(sink != -reps)
+                {   cout << "WRONG RESULT" << endl; return; }
+        }
+        cout << "  " << n << "\t\t" << t[0] << "\t\t" << t[1] << "\t\t" << t[0] / t[1] << "x" << endl;
+    }
+}
+
+int main(int argc, char const *argv[])
+{
+    if(!check_positions<char>() || !check_positions<short>() || !check_positions<int>() || !check_positions<long>()
+        || !check_positions<float>() || !check_positions<double>())
+    {   cout << "WRONG RESULT" << endl; return 1; }
+    char chs[] = "abc";
+    cout << "checks: ok (find(\"abc\", 'c') = " << find(chs, 3, 'c') << ")" << endl << endl;
+
+    cout << "  size\t\tone by one (ns/elem)\tvector (ns/elem)\tspeedup" << endl;
+    bench<char>("char");
+    bench<int>("int");
+    bench<long>("long");
+    bench<double>("double");
+    return 0;
+}
+#endif
+
+
+//-----------------------------------------------------------------------------------------------------
+/// Benchmark: searching a sorted int array: find() vs lower_bound vs find_sorted() vs EytzingerIndex ///
+// Tables that fit in L1 (32 KB), L2 (1 MB), L3 (64 MB) and only in DRAM (512 MB); random queries, half of them present.
+// First checks all three against a linear scan on small arrays with duplicates.
+#if 0
+#include <chrono>
+#include <random>
+
+bool check_sorted_search()
+{
+    mt19937 rng(7);
+    for(int n = 0; n < 300; n++)
+    {
+        vector<int> a(n);
+        for(int i = 0; i < n; i++)
+            a[i] = rng() % (n / 2 + 1);         // many duplicates
+        sort(a.begin(), a.end());
+        EytzingerIndex<int> e(a.data(), n);
+        for(int v = -1; v <= n / 2 + 1; v++)
+        {
+            int expect = -1;
+            for(int i = 0; i < n; i++)
+                if(a[i] == v)   {   expect = i; break; }
+            if(find_sorted(a.data(), n, v) != expect || e.find(v) != expect)
+            {
+                cout << "n = " << n << ", value = " << v << ": expected " << expect << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <class Search>
+double ns_per_query(const vector<int>& queries, long expect, Search search)
+{
+    long sink = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(size_t q = 0; q < queries.size(); q++)
+        sink += search(queries[q]) >= 0;
+    double t = chrono::duration<double>(chrono::steady_clock::now() - start).count() * 1e9 / queries.size();
+    if(sink != expect)
+        {   cout << "WRONG RESULT" << endl; exit(1); }
+    return t;
+}
+
+int main(int argc, char const *argv[])
+{
+    if(!check_sorted_search())
+        {   cout << "WRONG RESULT" << endl; return 1; }
+    cout << "checks: ok" << endl << endl;
+
+    const int sizes[] = { 8 << 10, 256 << 10, 16 << 20, 128 << 20 };
+    const char* names[] = { "L1", "L2", "L3", "DRAM" };
+    cout << "  size\t\t\tfind()\t\tlower_bound\tfind_sorted()\tEytzinger\t(ns/query)" << endl;
+    for(int s = 0; s < 4; s++)
+    {
+        int n = sizes[s];
+        vector<int> a(n);
+        for(int i = 0; i < n; i++)
+            a[i] = 2 * i;                       // even values: a query is present if it is even
+        EytzingerIndex<int> e(a.data(), n);
+
+        mt19937 rng(s);
+        vector<int> queries(1 << 22);
+        long present = 0;
+        for(size_t q = 0; q < queries.size(); q++)
+        {
+            queries[q] = rng() % (2u * n);
+            present += (queries[q] % 2 == 0);
+        }
+        const int* pa = a.data();
+        double t_bin = ns_per_query(queries, present,
+            [&](int v) { const int* p = lower_bound(pa, pa + n, v); return (p < pa + n && *p == v) ? int(p - pa) : -1; });
+        double t_bl = ns_per_query(queries, present, [&](int v) { return find_sorted(pa, n, v); });
+        double t_eyt = ns_per_query(queries, present, [&](int v) { return e.find(v); });
+
+        // the linear find() only gets a few queries on the big tables
+        vector<int> few(queries.begin(), queries.begin() + max(16, (1 << 24) / n));
+        long few_present = 0;
+        for(size_t q = 0; q < few.size(); q++)
+            few_present += (few[q] % 2 == 0);
+        double t_lin = ns_per_query(few, few_present, [&](int v) { return find(a.data(), n, v); });
+
+        cout << "  " << names[s] << " (" << n * sizeof(int) / 1024 << " KB)\t" << (s < 2 ? "\t" : "")
+             << t_lin << "\t\t" << t_bin << "\t\t" << t_bl << "\t\t" << t_eyt << endl;
+    }
+    return 0;
+}
+#endif
+
+
+//-----------------------------------------------------------------------------------------------------
+/// Benchmark: parallel_find() on 1, 2, 4 ... threads (strong scaling: the same 800 MB array for all) ///
+// First checks that it returns the first match with several matches around block edges, for ints and strings.
+#if 0
+#include <chrono>
+#include <random>
+
+bool check_parallel_find()
+{
+    mt19937 rng(3);
+    const long n = 1000000;                 // ~15 blocks
+    vector<int> a(n, 0);
+    for(int trial = 0; trial < 200; trial++)
+    {
+        int threads = 1 + trial % 8;
+        long first = (trial % 4 == 0) ? n - 1 - rng() % 100 : rng() % n;
+        if(trial % 3 == 0)
+            first = (first / 65536) * 65536 + (trial % 2 ? 0 : 65535);       // on a block edge
+        first = min(first, n - 1);
+        a[first] = 1;
+        vector<long> later;
+        for(int k = 0; k < 5; k++)          // more matches after the first one
+        {
+            long p = first + 1 + rng() % (n - first);
+            if(p < n)   {   a[p] = 1; later.push_back(p); }
+        }
+        long got = parallel_find(a.data(), n, 1, threads);
+        a[first] = 0;
+        for(size_t k = 0; k < later.size(); k++)
+            a[later[k]] = 0;
+        if(got != first)
+        {
+            cout << "threads = " << threads << ": expected " << first << ", got " << got << endl;
+            return false;
+        }
+    }
+    if(parallel_find(a.data(), n, 1, 4) != -1 || parallel_find(a.data(), 0, 1, 4) != -1)
+        return false;
+
+    vector<long double> ld(300000);         // (16 bytes: no vector compare, the plain loop)
+    for(size_t i = 0; i < ld.size(); i++)
+        ld[i] = i + 0.5L;
+    if(parallel_find(ld.data(), (long)ld.size(), 1000.5L, 3) != 1000 || parallel_find(ld.data(), (long)ld.size(), 7.0L, 3) != -1)
+        return false;
+
+    vector<string> s(300000, "a");
+    s[200001] = "b";
+    s[250000] = "b";
+    return parallel_find(s.data(), (long)s.size(), string("b"), 3) == 200001;
+}
+
+int main(int argc, char const *argv[])
+{
+    if(!check_parallel_find())
+        {   cout << "WRONG RESULT" << endl; return 1; }
+    cout << "checks: ok" << endl;
+
+    const long n = 200000000;
+    vector<int> a(n, 1);
+    int cores = max(1u, thread::hardware_concurrency());
+    cout << "cores: " << cores << endl << endl;
+    cout << "  threads\tnot found (ms)\tspeedup\t\tfound at 10% (ms)" << endl;
+    double t1 = 0;
+    for(int threads = 1; threads <= max(8, 2 * cores); threads *= 2)
+    {
+        double t[2];
+        for(int way = 0; way < 2; way++)
+        {
+            if(way == 1)    a[n / 10] = 2;
+            double fastest = 1e9;
+            for(int rep = 0; rep < 5; rep++)
+            {
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                long r = parallel_find(a.data(), n, 2, threads);
+                fastest = min(fastest, chrono::duration<double>(chrono::steady_clock::now() - start).count() * 1e3);
+                if(r != (way == 0 ? -1 : n / 10))
+                    {   cout << "WRONG RESULT" << endl; return 1; }
+            }
+            if(way == 1)    a[n / 10] = 1;
+            t[way] = fastest;
+        }
+        if(threads == 1)    t1 = t[0];
+        cout << "  " << threads << "\t\t" << t[0] << "\t\t" << t1 / t[0] << "x\t\t" << t[1] << endl;
+    }
+    return 0;
+}
+#endif
+
+
+//-----------------------------------------------------------------------------------------------------
+/// Benchmark: GrowStack vs Stack (MAX = 100) vs vector: push/pop time and memory ///
+// operator new/delete are replaced to count the heap bytes in use; Arena is a bump allocator that never frees.
+#if 0
+#include <chrono>
+#include <new>
+#include <cstdlib>
+
+long heapBytes = 0;
+void* operator new(size_t n)
+{
+    size_t* p = (size_t*)malloc(n + 16);    // (the size is kept in front of the block)
+    if(!p) throw bad_alloc();
+    heapBytes += n;
+    *p = n;
+    return (char*)p + 16;
+}
+void* operator new[](size_t n)          {   return operator new(n); }
+void operator delete(void* p) noexcept  {   if(p) { size_t* h = (size_t*)((char*)p - 16); heapBytes -= *h; free(h); } }
+void operator delete[](void* p) noexcept            {   operator delete(p); }
+void operator delete(void* p, size_t) noexcept      {   operator delete(p); }
+void operator delete[](void* p, size_t) noexcept    {   operator delete(p); }
+
+class Arena                             // hands out pieces of one big block, all freed at once by reset()
+{
+private:
+    char* block;
+    size_t size, used;
+public:
+    Arena(size_t bytes) : block(new char[bytes]), size(bytes), used(0)
+        { }
+    ~Arena()
+        {   delete[] block; }
+    void reset()
+        {   used = 0; }
+    void* get(size_t n)
+    {
+        n = (n + 15) & ~size_t(15);
+        if(n > size - used)
+            throw bad_alloc();
+        void* p = block + used;
+        used += n;
+        return p;
+    }
+};
+
+template <class T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+    Arena* arena;
+    ArenaAllocator(Arena* a) : arena(a)
+        { }
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& a) : arena(a.arena)
+        { }
+    T* allocate(size_t n)
+        {   return (T*)arena->get(n * sizeof(T)); }
+    void deallocate(T*, size_t)             // (freed with the arena)
+        { }
+    bool operator==(const ArenaAllocator& a) const
+        {   return arena == a.arena; }
+    bool operator!=(const ArenaAllocator& a) const
+        {   return arena != a.arena; }
+};
+
+struct Big                              // 64 bytes
+{
+    long v[8];
+    Big(long x = 0)
+        {   for(int j = 0; j < 8; j++) v[j] = x; }
+    long key() const
+        {   return v[0]; }
+};
+
+long keyOf(long x)              {   return x; }
+long keyOf(const string& s)     {   return (long)s.size(); }
+long keyOf(const Big& b)        {   return b.key(); }
+
+template <class T>
+T make(long j)
+{
+    if constexpr (is_same<T, string>::value)    return (j & 1) ? string("short") : string(40, 'x');
+    else                                        return T(j);
+}
+
+// ns per push+pop: 'items' pushed then popped, 'rounds' times, each round with a new stack
+template <class Stk, class T>
+double pushPop(int items, long rounds, Stk (*makeStack)())
+{
+    vector<T> values;
+    for(int j = 0; j < items; j++)
+        values.push_back(make<T>(j));
+    long sink = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(long r = 0; r < rounds; r++)
+    {
+        Stk s = makeStack();
+        for(int j = 0; j < items; j++)
+            s.push(values[j]);
+        for(int j = 0; j < items; j++)
+            sink += keyOf(s.pop());
+    }
+    double t = chrono::duration<double>(chrono::steady_clock::now() - start).count() * 1e9 / ((double)rounds * items);
+    if(sink == 42)  cout << "";
+    return t;
+}
+
+template <class T>
+struct VectorStack                      // vector used as a stack
+{
+    vector<T> v;
+    void push(const T& x)   {   v.push_back(x); }
+    T pop()                 {   T x(std::move(v.back())); v.pop_back(); return x; }
+};
+
+Arena* theArena;
+template <class T> Stack<T> bookStack()                         {   return Stack<T>(); }
+template <class T> VectorStack<T> vecStack()                    {   return VectorStack<T>(); }
+template <class T> GrowStack<T> growStack()                     {   return GrowStack<T>(); }
+template <class T> GrowStack<T, 16, ArenaAllocator<T> > arenaStack()     // (the last round's stack is gone: reuse its memory)
+    {   theArena->reset(); return GrowStack<T, 16, ArenaAllocator<T> >(ArenaAllocator<T>(theArena)); }
+
+// object size + heap bytes of a stack holding 'items' items
+template <class Stk, class T>
+long footprint(int items, Stk (*makeStack)())
+{
+    long before = heapBytes;
+    Stk* s = new Stk(makeStack());
+    for(int j = 0; j < items; j++)
+        s->push(make<T>(3));
+    long bytes = heapBytes - before;
+    delete s;
+    return bytes;
+}
+
+template <class T>
+void bench(const char* name)
+{
+    cout << name << " (" << sizeof(T) << " bytes)" << endl;
+    cout << "  items\tStack\t\tvector\t\tGrowStack\tGrowStack+Arena\t(ns per push+pop)" << endl;
+    const int counts[] = { 8, 100, 10000, 1000000 };
+    for(int c = 0; c < 4; c++)
+    {
+        int n = counts[c];
+        long rounds = max(1L, 20000000L / n);
+        cout << "  " << n << "\t";
+        if(n <= MAX)    cout << pushPop<Stack<T>, T>(n, rounds, bookStack<T>) << "\t\t";
+        else            cout << "overflow\t";
+        cout << pushPop<VectorStack<T>, T>(n, rounds, vecStack<T>) << "\t\t"
+             << pushPop<GrowStack<T>, T>(n, rounds, growStack<T>) << "\t\t"
+             << pushPop<GrowStack<T, 16, ArenaAllocator<T> >, T>(n, rounds, arenaStack<T>) << endl;
+    }
+    cout << "  memory (object + heap bytes) with 3 / 100 items:" << endl;
+    cout << "    Stack " << footprint<Stack<T>, T>(3, bookStack<T>) << " / " << footprint<Stack<T>, T>(100, bookStack<T>)
+         << ",  vector " << footprint<VectorStack<T>, T>(3, vecStack<T>) << " / " << footprint<VectorStack<T>, T>(100, vecStack<T>)
+         << ",  GrowStack " << footprint<GrowStack<T>, T>(3, growStack<T>) << " / " << footprint<GrowStack<T>, T>(100, growStack<T>)
+         << endl << endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    GrowStack<string, 2> s;                 // quick checks: growth, copies, moves, Empty
+    for(int j = 0; j < 50; j++)
+        s.push(to_string(j));
+    s.push(s.top());                        // (a reference into the stack while it grows)
+    GrowStack<string, 2> c(s), m(std::move(c)), a;
+    a = m;
+    a.push("x");
+    m = std::move(a);
+    bool ok = s.size() == 51 && c.empty() && m.size() == 52 && m.pop() == "x" && m.pop() == "49" && m.pop() == "49";
+    try
+        {   c.pop(); ok = false; }
+    catch(GrowStack<string, 2>::Empty)
+        { }
+    if(!ok)
+        {   cout << "WRONG RESULT" << endl; return 1; }
+    cout << "checks: ok" << endl << endl;
+
+    Arena arena(size_t(256) << 20);        // (all the blocks of 10^6 Big items: 2 * 64 MB)
+    theArena = &arena;
+    bench<int>("int");
+    bench<string>("string");
+    bench<Big>("Big");
+    return 0;
+}
+#endif
@@ -4,6 +4,7 @@
 #include <string>
 #include <cstdlib> //for srand(), rand()
 #include <ctime>   //for time for srand()
+#include "simd_cstring.h"    // fast_strlen(), fast_strcpy(): 16/32 chars at a time
 
 using namespace std;
 
@@ -153,13 +154,14 @@ public:
     String()
         { str[0] = '\0'; }
     String(char s[])
-        { strcpy(str, s); }
+        { fast_strcpy(str, s); }
     void display()
         { cout << str; }
     void concat(String s2)
     { 
-        if(strlen(str) + strlen(s2.str) < SZ)
-            { strcat(str, s2.str); }
+        size_t len = fast_strlen(str);
+        if(len + fast_strlen(s2.str) < SZ)
+            { fast_strcpy(str + len, s2.str); }     // strcat() without finding the end of str again
         else
             { cout << "\nString is too long"; }
     }
@@ -172,6 +174,8 @@ public:
             - and a longer string —if one were mistakenly generated— could crash the system 
                 by extending beyond the end of the array.
         • And, there is no bounds checking;
+        • concat() can't grow the array: past SZ chars it just prints an error.
+            (for strings built from many pieces, see the Rope class in 8_operator_overloading.cpp)
 */
 
 /* But,
@@ -1,6 +1,9 @@
 #include <iostream>
 #include <cstring>
 #include <stdlib.h>     // for exit(). You can also use <process.h>
+#include <vector>
+#include "simd_cstring.h"    // fast_strlen(), fast_strcpy(), fast_strcmp(): 16/32 chars at a time
+#include <algorithm>
 using namespace std;
 
 /* Here is where it gets exciting ☻ */
@@ -145,9 +148,9 @@ private:
     char str[SIZE];
 public:
     String()
-    {   strcpy(str, ""); }
+    {   str[0] = '\0'; }
     String(char s[])    // convert from C-string to String object.
-    {   strcpy(str, s); }
+    {   fast_strcpy(str, s); }
     void get_str()
     {   
         cin.ignore();
@@ -173,10 +176,11 @@ public:
 String String::operator +(String s2) const
 {
     String temp;
-    if(strlen(str) + strlen(s2.str) < SIZE)
+    size_t len = fast_strlen(str);
+    if(len + fast_strlen(s2.str) < SIZE)
     {
-        strcpy(temp.str, str);
-        strcat(temp.str, s2.str);
+        memcpy(temp.str, str, len);
+        fast_strcpy(temp.str + len, s2.str);
     }
     else
     {
@@ -184,10 +188,11 @@ String String::operator +(String s2) const
     }
     return temp;
 }
+// (for long strings built from many pieces, see the Rope class below: it never runs out of room and never copies twice)
 
 bool String::operator ==(String s2) const
 {   
-    return (strcmp(str, s2.str) == 0);
+    return (fast_strcmp(str, s2.str) == 0);
 }
 
 char& String::operator [](int i)    // An obj[i] can be used as L-value or R-value, so return by reference.
@@ -198,6 +203,282 @@ char& String::operator [](int i)    // An obj[i] can be used as L-value or R-val
 }
 
 
+/* A Rope String (for Concatenation-Heavy Work) .....................................*/
+/*
+    String::operator+ copies both operands into a fixed 80-char array (and gives up with exit(1) beyond that),
+    and even a String with a growing 'new' array would copy everything every time:
+        building an n-char string from small pieces with s = s + piece copies O(n²) chars in total.
+
+    ► A 'rope' never copies what it already has:
+        • It is a binary tree: leaves hold the actual chars ("chunks"), and an inner node stands for left + right.
+        • Two ropes can share parts of their trees: each node counts the ropes/nodes pointing to it,
+            is deleted by the last one (like StrWithCount in chapter 11), and is only changed while it has one owner.
+        • Concatenating two ropes makes one new node on top of the two trees (the deeper one is rebalanced if it gets too deep).
+    ► Small pieces are not made into leaves one by one (a 10-char leaf would cost more than its chars):
+        they are copied into the rope's 'tail' chunk, and only a full tail (CHUNK chars) is added to the tree,
+        on its right edge, keeping the tree balanced (depth = log2 of the number of chunks).
+        • r + piece may write into the same tail chunk r uses, but only past r's own length, so r doesn't change;
+            if another rope already wrote there, the tail is copied first.
+    ► The chars are only made one contiguous C-string (flattened) when c_str() is called.
+*/
+class Rope
+{
+private:
+    struct Chunk                    // chars shared by ropes; only ever appended to
+    {
+        int refs;
+        long used, cap;
+        char* data;                 // cap + 1 chars (room for a '\0')
+    };
+    struct Node                     // a leaf (first 'length' chars of 'chunk') or left + right
+    {
+        int refs;
+        int depth;                  // 0 for a leaf
+        long length;
+        Node *left, *right;
+        Chunk* chunk;
+    };
+    enum { CHUNK = 4096,            // biggest tail before it goes into the tree
+           MAX_DEPTH = 48 };        // rebalance a tree deeper than this
+
+    Node* tree;                     // all chars but the last few (may be NULL)
+    Chunk* tail;                    // the last chars: the first tailLen chars of this chunk (may be NULL)
+    long tailLen;
+
+    static Chunk* new_chunk(long cap)
+    {
+        Chunk* c = new Chunk;
+        c->refs = 1;    c->used = 0;    c->cap = cap;
+        c->data = new char[cap + 1];
+        return c;
+    }
+    static void release(Chunk* c)
+    {
+        if(c && --c->refs == 0)
+            {   delete[] c->data; delete c; }
+    }
+    static Node* new_leaf(Chunk* c, long len)
+    {
+        Node* n = new Node;
+        n->refs = 1;    n->depth = 0;   n->length = len;
+        n->left = n->right = NULL;
+        n->chunk = c;   c->refs++;
+        return n;
+    }
+    static Node* new_concat(Node* l, Node* r)       // takes over one reference to l and to r
+    {
+        Node* n = new Node;
+        n->refs = 1;
+        n->depth = max(l->depth, r->depth) + 1;
+        n->length = l->length + r->length;
+        n->left = l;    n->right = r;
+        n->chunk = NULL;
+        return n;
+    }
+    static void release(Node* n)
+    {
+        while(n && --n->refs == 0)
+        {
+            Node* right = n->right;
+            release(n->left);
+            release(n->chunk);
+            delete n;
+            n = right;              // loop instead of recursing on the right edge
+        }
+    }
+    // add a leaf on the right edge: go down the right while the left side is deeper (not full yet),
+    // so the tree fills up like a binary counter and stays balanced.
+    static Node* push_right(Node* t, Node* leaf)
+    {
+        if(!t)
+            return leaf;
+        if(t->depth > 0 && t->left->depth > t->right->depth)
+        {
+            if(t->refs == 1)                    // nobody else sees this node: change it in place
+            {
+                t->right = push_right(t->right, leaf);
+                t->length += leaf->length;
+                t->depth = max(t->left->depth, t->right->depth) + 1;
+                return t;
+            }
+            t->left->refs++;                    // shared: make a new node (the old one stays as it was)
+            t->right->refs++;
+            Node* n = new_concat(t->left, push_right(t->right, leaf));
+            release(t);
+            return n;
+        }
+        return new_concat(t, leaf);
+    }
+    static void collect(Node* t, vector<Node*>& leaves)
+    {
+        for( ; t->depth > 0; t = t->right)
+            {   collect(t->left, leaves); }
+        leaves.push_back(t);
+    }
+    static Node* build(Node** first, Node** last)   // balanced tree over the leaves [first, last)
+    {
+        if(last - first == 1)
+            {   (*first)->refs++; return *first; }
+        Node** mid = first + (last - first) / 2;
+        return new_concat(build(first, mid), build(mid, last));
+    }
+    static Node* rebalance(Node* t)
+    {
+        vector<Node*> leaves;
+        collect(t, leaves);
+        Node* n = build(&leaves[0], &leaves[0] + leaves.size());
+        release(t);
+        return n;
+    }
+    void push_tail()                // move the tail chars into the tree
+    {
+        if(tailLen > 0)
+            {   tree = push_right(tree, new_leaf(tail, tailLen)); }
+        release(tail);
+        tail = NULL;
+        tailLen = 0;
+    }
+    void append(const char* s, long n)
+    {
+        while(n > 0)
+        {
+            if(!tail || tailLen != tail->used || tailLen == tail->cap)
+            {
+                if(tail && tailLen >= CHUNK / 2)        // a big tail (full, or flattened by c_str()) goes into the tree
+                    {   push_tail(); }
+                // a new tail: a bigger copy of a small full one, or a copy of one that another rope wrote past our end
+                long cap = tree ? long(CHUNK) : min<long>(CHUNK, max<long>(64, 2 * (tailLen + n)));
+                Chunk* c = new_chunk(cap);
+                if(tailLen > 0)
+                    {   memcpy(c->data, tail->data, tailLen); }
+                c->used = tailLen;
+                release(tail);
+                tail = c;
+            }
+            long k = min(n, tail->cap - tailLen);
+            memcpy(tail->data + tailLen, s, k);
+            tailLen += k;
+            tail->used = tailLen;
+            s += k;
+            n -= k;
+        }
+    }
+    void append(const Rope& r)
+    {
+        if(!r.tree)
+        {
+            Chunk* keep = r.tail;               // (r may be this rope, whose tail append() may replace)
+            if(keep)    keep->refs++;
+            append(keep ? keep->data : "", r.tailLen);
+            release(keep);
+            return;
+        }
+        push_tail();
+        r.tree->refs++;
+        tree = tree ? new_concat(tree, r.tree) : r.tree;
+        if(tree->depth > MAX_DEPTH)
+            {   tree = rebalance(tree); }
+        tail = r.tail;                  // share r's tail (our appends will copy it if r wrote past it)
+        tailLen = r.tailLen;
+        if(tail)
+            {   tail->refs++; }
+    }
+public:
+    Rope() : tree(NULL), tail(NULL), tailLen(0)
+    {   }
+    Rope(const char* s) : tree(NULL), tail(NULL), tailLen(0)
+    {   append(s, fast_strlen(s)); }
+    Rope(const Rope& r) : tree(r.tree), tail(r.tail), tailLen(r.tailLen)
+    {
+        if(tree)    tree->refs++;
+        if(tail)    tail->refs++;
+    }
+    Rope(Rope&& r) noexcept : tree(r.tree), tail(r.tail), tailLen(r.tailLen)
+    {   r.tree = NULL; r.tail = NULL; r.tailLen = 0; }
+    ~Rope()
+    {   release(tree); release(tail); }
+    Rope& operator =(Rope r) noexcept   // (copy-and-swap: r is already our copy)
+    {
+        swap(tree, r.tree);
+        swap(tail, r.tail);
+        swap(tailLen, r.tailLen);
+        return *this;
+    }
+
+    long length() const
+    {   return (tree ? tree->length : 0) + tailLen; }
+
+    Rope operator +(const Rope& r) const
+    {   Rope temp(*this); temp.append(r); return temp; }
+    Rope operator +(const char* s) const
+    {   Rope temp(*this); temp.append(s, fast_strlen(s)); return temp; }
+    Rope& operator +=(const Rope& r)
+    {   append(r); return *this; }
+    Rope& operator +=(const char* s)
+    {   append(s, fast_strlen(s)); return *this; }
+
+    char operator [](long i) const      // O(log n): walk down to the leaf
+    {
+        if(i < 0 || i >= length())
+        {   cout << "\nIndex out of bounds"; exit(1); }
+        if(tree && i < tree->length)
+        {
+            Node* t = tree;
+            while(t->depth > 0)
+            {
+                if(i < t->left->length)
+                    t = t->left;
+                else
+                    {   i -= t->left->length; t = t->right; }
+            }
+            return t->chunk->data[i];
+        }
+        return tail->data[i - (tree ? tree->length : 0)];
+    }
+
+    // flatten to one chunk (the first time) and return it as a C-string.
+    // (valid until this rope is changed)
+    const char* c_str()
+    {
+        if(tree || !tail || tailLen != tail->cap)
+        {
+            long len = length();
+            Chunk* c = new_chunk(len);                  // exactly full, so no other rope can append into it
+            long pos = 0;
+            if(tree)
+            {
+                vector<Node*> leaves;
+                collect(tree, leaves);
+                for(size_t j = 0; j < leaves.size(); j++)
+                {
+                    memcpy(c->data + pos, leaves[j]->chunk->data, leaves[j]->length);
+                    pos += leaves[j]->length;
+                }
+            }
+            if(tailLen > 0)
+                {   memcpy(c->data + pos, tail->data, tailLen); }
+            c->used = len;
+            release(tree);  tree = NULL;
+            release(tail);  tail = c;   tailLen = len;
+        }
+        tail->data[tailLen] = '\0';
+        return tail->data;
+    }
+    void display() const                // prints leaf by leaf, without flattening
+    {
+        if(tree)
+        {
+            vector<Node*> leaves;
+            collect(tree, leaves);
+            for(size_t j = 0; j < leaves.size(); j++)
+                {   cout.write(leaves[j]->chunk->data, leaves[j]->length); }
+        }
+        if(tailLen > 0)
+            {   cout.write(tail->data, tailLen); }
+    }
+};
+
+
 // Conversions between objects of user-defined types
 class Time12;       // forward declaration
 class Time24;
@@ -312,6 +593,8 @@ Time24::operator Time12() const     // Time12 ← Time24
         So, you have to put the 'from' and 'to your class' conversion routines in your defined class.
 */
 
+// main()
+#if 1
 int main()
 {
     /* Unary Operators .............................. */
@@ -444,6 +727,7 @@ int main()
 
     return 0;
 }
+#endif
 
 
 /*
@@ -493,4 +777,102 @@ int main()
 
         - Not all operators can be overloaded.
             (. , :: , ?: , -> , creating new operators) cannot be overloaded.
-*/
\ No newline at end of file
+*/
+
+
+
+/* Benchmark: building a 100 MB string out of 10-char pieces .........................*/
+// Rope (r = r + piece, and r += piece) against std::string +=, and against a String that copies both operands on every + (only up to 512 KB: it's O(n²)).
+// Also checks the rope's chars against std::string after random concatenations of ropes and pieces.
+#if 0
+#include <chrono>
+#include <string>
+
+double seconds_since(chrono::steady_clock::time_point start)
+{   return chrono::duration<double>(chrono::steady_clock::now() - start).count(); }
+
+char* copy_concat(const char* a, const char* b)     // what a heap String's operator+ has to do
+{
+    int la = strlen(a), lb = strlen(b);
+    char* s = new char[la + lb + 1];
+    memcpy(s, a, la);
+    memcpy(s + la, b, lb + 1);
+    return s;
+}
+
+int main()
+{
+    const long TOTAL = 100L << 20;          // 100 MB
+    const char* piece = "0123456789";
+    chrono::steady_clock::time_point start;
+
+    for(long kb = 128; kb <= 512; kb *= 2)
+    {
+        char* s = copy_concat("", "");
+        start = chrono::steady_clock::now();
+        for(long n = 0; n < (kb << 10); n += 10)
+        {
+            char* t = copy_concat(s, piece);
+            delete[] s;
+            s = t;
+        }
+        cout << "copying String s = s + piece, " << kb << " KB:\t" << seconds_since(start) << " s" << endl;
+        delete[] s;
+    }
+
+    string ref;
+    start = chrono::steady_clock::now();
+    for(long n = 0; n < TOTAL; n += 10)
+        ref += piece;
+    cout << "std::string += piece, 100 MB:\t\t" << seconds_since(start) << " s" << endl;
+
+    {
+        Rope r;
+        start = chrono::steady_clock::now();
+        for(long n = 0; n < TOTAL; n += 10)
+            r = r + piece;
+        cout << "Rope r = r + piece, 100 MB:\t\t" << seconds_since(start) << " s" << endl;
+    }
+
+    Rope r;
+    start = chrono::steady_clock::now();
+    for(long n = 0; n < TOTAL; n += 10)
+        r += piece;
+    cout << "Rope r += piece, 100 MB:\t\t" << seconds_since(start) << " s" << endl;
+
+    start = chrono::steady_clock::now();
+    Rope twice = r + r;                     // sharing: no chars copied
+    cout << "Rope r + r (200 MB):\t\t\t" << seconds_since(start) * 1e6 << " us" << endl;
+
+    start = chrono::steady_clock::now();
+    const char* flat = r.c_str();
+    cout << "Rope c_str() (flatten 100 MB):\t\t" << seconds_since(start) << " s" << endl;
+    if(r.length() != (long)ref.size() || memcmp(flat, ref.data(), ref.size()) != 0 || twice[r.length() + 12345] != ref[12345])
+    {   cout << "WRONG RESULT" << endl; return 1; }
+
+    // random concatenations of ropes, checked against std::string
+    unsigned seed = 3;
+    Rope ropes[8];
+    string strs[8];
+    for(int step = 0; step < 200000; step++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        int a = (seed >> 8) % 8, b = (seed >> 12) % 8;
+        if(strs[a].size() + strs[b].size() > (1 << 20))     // keep them under 1 MB
+            {   ropes[a] = Rope(); strs[a].clear(); }
+        switch((seed >> 16) % 5)
+        {
+        case 0: ropes[a] = ropes[a] + (piece + (seed >> 20) % 10);  strs[a] += piece + (seed >> 20) % 10; break;
+        case 1: ropes[a] += ropes[b];               strs[a] += string(strs[b]); break;
+        case 2: ropes[a] = ropes[b] + ropes[a];     strs[a] = strs[b] + strs[a]; break;
+        case 3: ropes[a] = ropes[b];                strs[a] = strs[b]; break;
+        case 4: ropes[b].c_str(); break;
+        }
+    }
+    for(int j = 0; j < 8; j++)
+        if(strs[j] != ropes[j].c_str())
+        {   cout << "WRONG RESULT in rope " << j << endl; return 1; }
+    cout << "\nrandom concatenations: ok" << endl;
+    return 0;
+}
+#endif
@@ -0,0 +1,174 @@
+#ifndef SIMD_CSTRING_H
+#define SIMD_CSTRING_H
+// Vectorized C-string functions: fast_strlen(), fast_strcpy(), fast_strcmp(), fast_strchr()
+// (used by the String classes and C-string helpers of chapters 7, 8 and 10: #include "simd_cstring.h")
+
+#include <cstring>
+#include <cstddef>
+#include <stdint.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/* How they work:
+    • Instead of looking at one char at a time, they load 16 chars (SSE2) or 32 chars (AVX2) into one register,
+        compare all of them with '\0' (or with the char searched for) in one instruction,
+        and turn the result into a bit mask: one bit per char. The first set bit is the answer.
+    • Reading past the '\0' is harmless as long as we don't touch a memory page that isn't ours:
+        → strlen/strchr only do aligned loads (a 16/32-byte aligned block never crosses a 4 KB page),
+            and ignore the bits of the chars before the start of the string.
+        → strcmp walks two strings that are aligned differently, so it checks that neither load crosses into a new page,
+            and goes one char at a time for that block when one would.
+    • Address sanitizers would still complain about the bytes read around a string, so they are told not to check these reads
+        (but not fast_strcpy()'s writes: those never go past the '\0').
+*/
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CSTR_NO_SANITIZE __attribute__((no_sanitize_address))
+#define CSTR_CTZ(x) __builtin_ctz(x)
+#else
+#define CSTR_NO_SANITIZE
+#endif
+
+const uintptr_t CSTR_PAGE = 4096;
+
+#if defined(__AVX2__)
+#define CSTR_VEC_BYTES 32               // (a macro, so that #if can see it)
+const int CSTR_VEC = 32;
+typedef __m256i cstr_vec;
+CSTR_NO_SANITIZE inline cstr_vec cstr_load(const char* p)     {   return _mm256_load_si256((const __m256i*)p); }
+CSTR_NO_SANITIZE inline cstr_vec cstr_loadu(const char* p)    {   return _mm256_loadu_si256((const __m256i*)p); }
+inline void cstr_storeu(char* p, cstr_vec v)    {   _mm256_storeu_si256((__m256i*)p, v); }
+inline cstr_vec cstr_splat(char c)              {   return _mm256_set1_epi8(c); }
+inline cstr_vec cstr_min(cstr_vec a, cstr_vec b)    {   return _mm256_min_epu8(a, b); }
+inline unsigned cstr_eq(cstr_vec a, cstr_vec b)     {   return (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)); }
+#elif defined(__SSE2__)
+#define CSTR_VEC_BYTES 16
+const int CSTR_VEC = 16;
+typedef __m128i cstr_vec;
+CSTR_NO_SANITIZE inline cstr_vec cstr_load(const char* p)     {   return _mm_load_si128((const __m128i*)p); }
+CSTR_NO_SANITIZE inline cstr_vec cstr_loadu(const char* p)    {   return _mm_loadu_si128((const __m128i*)p); }
+inline void cstr_storeu(char* p, cstr_vec v)    {   _mm_storeu_si128((__m128i*)p, v); }
+inline cstr_vec cstr_splat(char c)              {   return _mm_set1_epi8(c); }
+inline cstr_vec cstr_min(cstr_vec a, cstr_vec b)    {   return _mm_min_epu8(a, b); }
+inline unsigned cstr_eq(cstr_vec a, cstr_vec b)     {   return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)); }
+#endif
+
+
+#if defined(CSTR_VEC_BYTES) && defined(CSTR_CTZ)
+
+// number of chars before the '\0'
+CSTR_NO_SANITIZE inline size_t fast_strlen(const char* s)
+{
+    const cstr_vec zero = cstr_splat(0);
+    const char* p = (const char*)((uintptr_t)s & ~(uintptr_t)(CSTR_VEC - 1));     // aligned block holding s[0]
+    unsigned mask = cstr_eq(cstr_load(p), zero) >> (s - p);     // drop the chars before s
+    if(mask)
+        return CSTR_CTZ(mask);
+
+    // one block at a time until p is aligned to 4 blocks (4 aligned blocks are always in one page)
+    for(p += CSTR_VEC; (uintptr_t)p & (4 * CSTR_VEC - 1); p += CSTR_VEC)
+    {
+        if((mask = cstr_eq(cstr_load(p), zero)))
+            return p - s + CSTR_CTZ(mask);
+    }
+    // then 4 blocks per loop: the min of the 4 blocks has a 0 byte only if one of them has
+    for( ; ; p += 4 * CSTR_VEC)
+    {
+        cstr_vec a = cstr_load(p),                b = cstr_load(p + CSTR_VEC);
+        cstr_vec c = cstr_load(p + 2 * CSTR_VEC), d = cstr_load(p + 3 * CSTR_VEC);
+        if(cstr_eq(cstr_min(cstr_min(a, b), cstr_min(c, d)), zero))
+        {
+            if((mask = cstr_eq(a, zero)))   return p - s + CSTR_CTZ(mask);
+            if((mask = cstr_eq(b, zero)))   return p - s + CSTR_VEC + CSTR_CTZ(mask);
+            if((mask = cstr_eq(c, zero)))   return p - s + 2 * CSTR_VEC + CSTR_CTZ(mask);
+            mask = cstr_eq(d, zero);
+            return p - s + 3 * CSTR_VEC + CSTR_CTZ(mask);
+        }
+    }
+}
+
+// pointer to the first 'ch' in s (the '\0' itself if ch is 0), or NULL
+CSTR_NO_SANITIZE inline const char* fast_strchr(const char* s, int ch)
+{
+    const cstr_vec zero = cstr_splat(0), c = cstr_splat((char)ch);
+    const char* p = (const char*)((uintptr_t)s & ~(uintptr_t)(CSTR_VEC - 1));
+    cstr_vec v = cstr_load(p);
+    unsigned mask = (cstr_eq(v, zero) | cstr_eq(v, c)) >> (s - p);
+    if(mask)
+    {
+        const char* q = s + CSTR_CTZ(mask);
+        return (*q == (char)ch) ? q : NULL;
+    }
+    for(p += CSTR_VEC; ; p += CSTR_VEC)
+    {
+        v = cstr_load(p);
+        if((mask = cstr_eq(v, zero) | cstr_eq(v, c)))
+        {
+            const char* q = p + CSTR_CTZ(mask);
+            return (*q == (char)ch) ? q : NULL;
+        }
+    }
+}
+
+// <0, 0 or >0 like strcmp() (chars compared as unsigned char)
+CSTR_NO_SANITIZE inline int fast_strcmp(const char* s1, const char* s2)
+{
+    const cstr_vec zero = cstr_splat(0);
+    const unsigned ALL = (CSTR_VEC == 32) ? 0xFFFFFFFFu : 0xFFFFu;
+    for(size_t i = 0; ; i += CSTR_VEC)
+    {
+        if(((uintptr_t)(s1 + i) & (CSTR_PAGE - 1)) > CSTR_PAGE - CSTR_VEC ||
+           ((uintptr_t)(s2 + i) & (CSTR_PAGE - 1)) > CSTR_PAGE - CSTR_VEC)
+        {
+            for(size_t j = i; j < i + CSTR_VEC; j++)    // near a page end: one char at a time
+            {
+                unsigned char a = s1[j], b = s2[j];
+                if(a != b || a == 0)
+                    return a - b;
+            }
+            continue;
+        }
+        cstr_vec a = cstr_loadu(s1 + i), b = cstr_loadu(s2 + i);
+        unsigned mask = (~cstr_eq(a, b) & ALL) | cstr_eq(a, zero);     // first difference or end
+        if(mask)
+        {
+            size_t k = i + CSTR_CTZ(mask);
+            return (unsigned char)s1[k] - (unsigned char)s2[k];
+        }
+    }
+}
+
+// copies src with its '\0' into dst, returns dst (in one pass: each block is stored as soon as it has no '\0')
+// (not CSTR_NO_SANITIZE: the stores never go past dst[strlen(src)], so a sanitizer can still check them)
+inline char* fast_strcpy(char* dst, const char* src)
+{
+    const cstr_vec zero = cstr_splat(0);
+    const char* p = (const char*)((uintptr_t)src & ~(uintptr_t)(CSTR_VEC - 1));
+    unsigned mask = cstr_eq(cstr_load(p), zero) >> (src - p);
+    if(mask)
+        return (char*)memcpy(dst, src, CSTR_CTZ(mask) + 1);
+    // no '\0' in [src, p + CSTR_VEC): copy just these chars (a full vector from src could reach past the '\0')
+    memcpy(dst, src, p + CSTR_VEC - src);
+    for(p += CSTR_VEC; ; p += CSTR_VEC)
+    {
+        cstr_vec v = cstr_load(p);
+        if((mask = cstr_eq(v, zero)))
+        {
+            memcpy(dst + (p - src), p, CSTR_CTZ(mask) + 1);
+            return dst;
+        }
+        cstr_storeu(dst + (p - src), v);
+    }
+}
+
+#else   // no SSE2: the library functions
+
+inline size_t fast_strlen(const char* s)                    {   return strlen(s); }
+inline const char* fast_strchr(const char* s, int ch)       {   return strchr(s, ch); }
+inline int fast_strcmp(const char* s1, const char* s2)      {   return strcmp(s1, s2); }
+inline char* fast_strcpy(char* dst, const char* src)        {   return strcpy(dst, src); }
+
+#endif
+
+#endif // SIMD_CSTRING_H